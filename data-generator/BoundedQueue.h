@@ -0,0 +1,60 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+// FIFO connecting two stages of the pipeline, push() blocks while the queue is full
+// so a fast producer waits for the consumer (backpressure) and the memory stays bounded
+template<typename T>
+class BoundedQueue {
+private:
+    QList<T> _items;
+    int _capacity;
+    bool _closed = false;
+
+    QMutex _mutex;
+    QWaitCondition _notFull;
+    QWaitCondition _notEmpty;
+
+public:
+    explicit BoundedQueue(int capacity) : _capacity(qMax(1, capacity)) {}
+
+    void push(T item) {
+        QMutexLocker locker(&_mutex);
+        while(_items.size() >= _capacity) {
+            _notFull.wait(&_mutex);
+        }
+
+        _items.append(item);
+        _notEmpty.wakeOne();
+    }
+
+    // waits for the next item, returns false once the queue is closed and drained
+    bool pop(T& item) {
+        QMutexLocker locker(&_mutex);
+        while(_items.isEmpty() && !_closed) {
+            _notEmpty.wait(&_mutex);
+        }
+
+        if(_items.isEmpty()) {
+            return false;
+        }
+
+        item = _items.takeFirst();
+        _notFull.wakeOne();
+
+        return true;
+    }
+
+    // no more items will be pushed
+    void close() {
+        QMutexLocker locker(&_mutex);
+        _closed = true;
+        _notEmpty.wakeAll();
+    }
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -62,6 +62,29 @@ public:
                zmin <= tp.z() && tp.z() <= zmax;
     }
 
+    inline float getBoundingRadius() override {
+        return this->_size.length() * 0.5f;
+    }
+
+    inline QVector3D getExtents() override {
+        // sum of the rotated half axes
+        QVector3D ax = this->_rotation.rotatedVector(QVector3D(this->_size.x() * 0.5f, 0, 0));
+        QVector3D ay = this->_rotation.rotatedVector(QVector3D(0, this->_size.y() * 0.5f, 0));
+        QVector3D az = this->_rotation.rotatedVector(QVector3D(0, 0, this->_size.z() * 0.5f));
+
+        return QVector3D(qAbs(ax.x()) + qAbs(ay.x()) + qAbs(az.x()),
+                         qAbs(ax.y()) + qAbs(ay.y()) + qAbs(az.y()),
+                         qAbs(ax.z()) + qAbs(ay.z()) + qAbs(az.z()));
+    }
+
+    inline float getVolume() override {
+        return this->_size.x() * this->_size.y() * this->_size.z();
+    }
+
+    inline void scale(float factor) override {
+        this->_size *= factor;
+    }
+
     inline QList<QVector3D> getBoundingBox() override {
         QList<QVector3D> list;
 
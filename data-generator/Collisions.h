@@ -29,6 +29,21 @@ public:
 
         return false;
     }
+
+    // tests the object against the other ones of the list, only those closer than the sum of the bounding radii
+    // are tested exactly (the object itself may be in the list)
+    template<class List>
+    static bool collides(Object* obj, const List& others)
+    {
+        for(auto o : others) {
+            float r = o->getBoundingRadius() + obj->getBoundingRadius();
+            if(o != obj && (o->getPosition() - obj->getPosition()).lengthSquared() < r * r && intersect(obj, o)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
 };
 
 
@@ -5,6 +5,7 @@
 #include <QDebug>
 #include <QQuaternion>
 #include <QSizeF>
+#include <QtMath>
 
 #include "Object.h"
 
@@ -56,6 +57,23 @@ public:
         return ((a*a) + (b*b) + (c*c)) < 1;
     }
 
+    inline float getBoundingRadius() override {
+        return qMax(this->_size.x(), qMax(this->_size.y(), this->_size.z()));
+    }
+
+    // contains() does not rotate the ellipsoid, so neither do the extents
+    inline QVector3D getExtents() override {
+        return this->_size;
+    }
+
+    inline float getVolume() override {
+        return 4.0f / 3.0f * (float)M_PI * this->_size.x() * this->_size.y() * this->_size.z();
+    }
+
+    inline void scale(float factor) override {
+        this->_size *= factor;
+    }
+
     inline QList<QVector3D> getBoundingBox() override {
         QList<QVector3D> list;
 
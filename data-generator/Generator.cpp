@@ -0,0 +1,831 @@
+#include <QVector3D>
+#include <QFile>
+#include <QtMath>
+#include <QDebug>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <climits>
+
+#include "Generator.h"
+
+#include "Sphere.h"
+#include "Box.h"
+#include "Ellipsoid.h"
+
+#include "Collisions.h"
+#include "BoundedQueue.h"
+#include "VoxelLayout.h"
+
+// random number in [0, 1)
+static inline float random01()
+{
+    return qrand() / (RAND_MAX + 1.0f);
+}
+
+static Object* createObject(uchar type, uchar id, QVector3D position, uchar value, uchar size, uchar orientation)
+{
+    switch (type) {
+        case 1:
+            return new Sphere(id, position, value, size, orientation);
+        case 2:
+            return new Ellipsoid(id, position, value, size, orientation);
+        case 3:
+            return new Box(id, position, value, size, orientation);
+    }
+
+    return nullptr;
+}
+
+// uniform grid of the objects for the neighbourhood queries of the Poisson-disk placement
+class PlacementGrid {
+private:
+    int _n;
+    float _cell;
+    QVector<QVector<Object*>> _cells;
+
+    inline int cellOf(float v) const { return qBound(0, (int)(v / _cell), _n - 1); }
+
+public:
+    // cells are at least as large as the diameter of the largest object
+    PlacementGrid(float maxRadius) {
+        _n = qMax(1, (int)(1.0f / (2.0f * maxRadius)));
+        _cell = 1.0f / _n;
+        _cells.resize(_n * _n * _n);
+    }
+
+    void insert(Object* obj) {
+        QVector3D p = obj->getPosition();
+        _cells[(cellOf(p.z()) * _n + cellOf(p.y())) * _n + cellOf(p.x())].append(obj);
+    }
+
+    // tests the object against its neighbours
+    bool collides(Object* obj) {
+        QVector3D p = obj->getPosition();
+        int cx = cellOf(p.x()), cy = cellOf(p.y()), cz = cellOf(p.z());
+
+        for(int z = qMax(0, cz - 1); z <= qMin(_n - 1, cz + 1); z++) {
+            for(int y = qMax(0, cy - 1); y <= qMin(_n - 1, cy + 1); y++) {
+                for(int x = qMax(0, cx - 1); x <= qMin(_n - 1, cx + 1); x++) {
+                    if(Collisions::collides(obj, _cells[(z * _n + y) * _n + x])) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+};
+
+// volume of the part of the object inside the grid (unit cube), the part of an object reaching out of it
+// is measured on a lattice over its extents (deterministic, the random sequence of the scene stays the same)
+static float clippedVolume(Object* obj)
+{
+    QVector3D lo = obj->getPosition() - obj->getExtents();
+    QVector3D hi = obj->getPosition() + obj->getExtents();
+    if(lo.x() >= 0.0f && lo.y() >= 0.0f && lo.z() >= 0.0f && hi.x() <= 1.0f && hi.y() <= 1.0f && hi.z() <= 1.0f) {
+        return obj->getVolume();
+    }
+
+    const int n = 16;
+    int inside = 0, clipped = 0;
+    for(int k = 0; k < n; k++) {
+        for(int j = 0; j < n; j++) {
+            for(int i = 0; i < n; i++) {
+                QVector3D p = lo + (hi - lo) * ((QVector3D(i, j, k) + QVector3D(0.5f, 0.5f, 0.5f)) / n);
+                if(obj->contains(p)) {
+                    inside++;
+                    if(p.x() >= 0.0f && p.x() < 1.0f && p.y() >= 0.0f && p.y() < 1.0f && p.z() >= 0.0f && p.z() < 1.0f) {
+                        clipped++;
+                    }
+                }
+            }
+        }
+    }
+
+    return inside > 0 ? obj->getVolume() * clipped / inside : 0.0f;
+}
+
+// Bridson-style Poisson-disk sampling with variable radii: new objects are tried in a shell
+// around a random active object, the object retires after a number of failed candidates
+// every object is tried a bounded amount of times, so the placement ends even when the scene is full
+static QList<Object*> placePoisson(Settings* set)
+{
+    const int candidates = 30;
+
+    QList<Object*> objects;
+    QList<Object*> active;
+
+    // largest bounding radius of all the allowed types and sizes
+    float maxRadius = 0.0f;
+    for(auto type : set->allowedTypes) {
+        for(uchar size = 0; size < 8; size++) {
+            Object* o = createObject(type, 0, QVector3D(), 0, size, 1);
+            maxRadius = qMax(maxRadius, o->getBoundingRadius());
+            delete o;
+        }
+    }
+    PlacementGrid grid(maxRadius);
+
+    float volume = 0.0f;
+    auto done = [&]() {
+        return set->targetFraction > 0.0f ? volume >= set->targetFraction : objects.size() >= set->targetCount;
+    };
+
+    while(!done()) {
+        // IDs are single bytes and 0 is the empty voxel
+        if(objects.size() == MAX_OBJECTS) {
+            qCritical() << "placement stopped at" << MAX_OBJECTS << "objects (IDs are a single byte),"
+                        << "use larger size classes to reach the target";
+            break;
+        }
+
+        uchar type = set->allowedTypes[qrand() % set->allowedTypes.size()];
+        uchar size = qrand() % 8; // 8 possible size classes
+        uchar orientation = qrand() % 8; // 8 possible orientations
+        uchar value = size * 32;
+        uchar id = objects.size() + 1;
+
+        Object* obj = createObject(type, id, QVector3D(), value, size, orientation);
+        float r = obj->getBoundingRadius();
+
+        // the very first object is placed anywhere
+        Object* parent = nullptr;
+        int tries = 1;
+        if(!objects.isEmpty()) {
+            if(active.isEmpty()) {
+                delete obj;
+                qDebug() << "scene is full, no more objects fit";
+                break;
+            }
+            parent = active[qrand() % active.size()];
+            tries = candidates;
+        }
+
+        bool placed = false;
+        for(int i = 0; i < tries && !placed; i++) {
+            QVector3D p(random01(), random01(), random01());
+
+            if(parent != nullptr) {
+                // random direction, distance in the shell [rp + r, rp + 2r]
+                float cz = 2.0f * random01() - 1.0f;
+                float phi = 2.0f * (float)M_PI * random01();
+                float s = qSqrt(1.0f - cz * cz);
+                float distance = parent->getBoundingRadius() + r * (1.0f + random01());
+
+                p = parent->getPosition() + QVector3D(s * qCos(phi), s * qSin(phi), cz) * distance;
+                if(p.x() < 0.0f || p.x() >= 1.0f || p.y() < 0.0f || p.y() >= 1.0f || p.z() < 0.0f || p.z() >= 1.0f) {
+                    continue;
+                }
+            }
+
+            obj->setPosition(p);
+            placed = set->canOverlap || !grid.collides(obj);
+        }
+
+        if(placed) {
+            objects.append(obj);
+            active.append(obj);
+            grid.insert(obj);
+            volume += clippedVolume(obj);
+
+            qDebug() << obj->getName() << " " << obj->getPosition() << " " << obj->getSize();
+        } else {
+            // all the candidates around the parent failed, it will not be tried again
+            active.removeOne(parent);
+            delete obj;
+        }
+    }
+
+    qDebug() << objects.size() << " objects generated, volume fraction" << volume;
+
+    return objects;
+}
+
+QList<Object*> generateObjects(Settings* set)
+{
+    // initialization of the seed
+    // set the seed in the settings if you want the very same random generator everytime!
+    if(set->seed != 0) {
+        qsrand(set->seed);
+    } else {
+        qsrand(QDateTime::currentMSecsSinceEpoch() / 1000);
+    }
+
+    if(set->placement == 1) {
+        return placePoisson(set);
+    }
+
+    // generate a bunch of objects
+    QList<Object*> objects;
+
+    while(objects.size() < set->targetCount) {
+        // random position
+        float x = (qrand() % 100) * 0.01f;
+        float y = (qrand() % 100) * 0.01f;
+        float z = (qrand() % 100) * 0.01f;
+
+        uchar type = set->allowedTypes[qrand() % set->allowedTypes.size()];
+        uchar size = qrand() % 8; // 8 possible size classes
+        uchar orientation = qrand() % 8; // 8 possible orientations
+        uchar value = size * 32;
+        uchar id = objects.size() + 1;
+
+        Object* obj = nullptr;
+        switch (type) {
+            case 1:
+                obj = new Sphere(id, QVector3D(x, y, z), value, size, orientation);
+                break;
+            case 2:
+                obj = new Ellipsoid(id, QVector3D(x, y, x), value, size, orientation);
+                break;
+            case 3:
+                obj = new Box(id, QVector3D(x,y,z), value, size, orientation);
+                break;
+        }
+
+        // check the collision
+        bool collision = false;
+        if(!set->canOverlap) {
+            for(int i = 0; i < objects.size(); i++) {
+                if(Collisions::intersect(obj, objects[i])) {
+                    collision = true;
+                    break;
+                }
+            }
+        }
+
+        if(set->canOverlap || !collision) {
+            objects.append(obj);
+
+            qDebug() << obj->getName() << " " << obj->getPosition() << " " << obj->getSize();
+        } else {
+            delete obj;
+        }
+    }
+
+    qDebug() << objects.size() << " objects generated";
+
+    return objects;
+}
+
+// formats of the output types, a new layout (VoxelLayout.h) only needs to be added here
+static const VoxelFormat* voxelFormat(int outputType)
+{
+    static const VoxelFormat formats[] = {
+        VoxelFormat::of<ValueLayout>("-8b"),
+        VoxelFormat::of<PackedLayout>("-32b"),
+        VoxelFormat::of<FloatLayout>("-160b"),
+        VoxelFormat::of<LabelLayout>("-labels")
+    };
+
+    if(outputType < 0 || outputType >= (int)(sizeof(formats) / sizeof(formats[0]))) {
+        return nullptr;
+    }
+
+    return &formats[outputType];
+}
+
+// tests whether the bounding sphere of the object reaches into [lo, hi] along the axis
+static inline bool overlaps(Object* obj, int axis, float lo, float hi)
+{
+    // small margin covers the rounding in contains()
+    float r = obj->getBoundingRadius() + 1e-4f;
+    float p = obj->getPosition()[axis];
+
+    return p + r >= lo && p - r <= hi;
+}
+
+QVector<Object*> resolveRegion(QList<Object*> objects, Settings* set, Region region, VoxelStats* stats)
+{
+    // voxels outside the grid do not exist
+    region = region.clipped(set->w, set->h, set->d);
+    if(region.voxels() > INT_MAX) {
+        qCritical() << "region of" << region.voxels() << "voxels is too large";
+        return QVector<Object*>();
+    }
+
+    float partX = 1.0f / set->w;
+    float partY = 1.0f / set->h;
+    float partZ = 1.0f / set->d;
+
+    QVector<Object*> labels;
+    labels.reserve((int)region.voxels());
+
+    // voxel centers span [lo, hi] along every axis of the region
+    float xlo = region.x0 * partX + partX * 0.5f, xhi = (region.x1 - 1) * partX + partX * 0.5f;
+    float ylo = region.y0 * partY + partY * 0.5f, yhi = (region.y1 - 1) * partY + partY * 0.5f;
+
+    // only objects reaching into the region are tested, their order is kept
+    // so the voxel always belongs to the first object containing it (regardless of the region)
+    QVector<Object*> candidates;
+    for(auto o : objects) {
+        if(overlaps(o, 0, xlo, xhi) && overlaps(o, 1, ylo, yhi)) {
+            candidates.append(o);
+        }
+    }
+
+    // rasterizing grid, candidates are narrowed down for every slice and row
+    QVector<Object*> slice, row;
+    for(int z = region.z0; z < region.z1; z++) {
+        float cz = z * partZ + partZ * 0.5f;
+
+        slice.clear();
+        for(auto o : candidates) {
+            if(overlaps(o, 2, cz, cz)) {
+                slice.append(o);
+            }
+        }
+
+        for(int x = region.x0; x < region.x1; x++) {
+            float cx = x * partX + partX * 0.5f;
+
+            row.clear();
+            for(auto o : slice) {
+                if(overlaps(o, 0, cx, cx)) {
+                    row.append(o);
+                }
+            }
+
+            for(int y = region.y0; y < region.y1; y++) {
+                auto center = QVector3D(cx, y * partY + partY * 0.5f, cz);
+
+                Object* obj = nullptr;
+                for(auto o : row) {
+                    if(o->contains(center)) {
+                        obj = o;
+                        break;
+                    }
+                }
+
+                if(stats != nullptr) {
+                    stats->add(x, y, z, obj);
+                }
+
+                labels.append(obj);
+            }
+        }
+    }
+
+    return labels;
+}
+
+QByteArray encodeRegion(const QVector<Object*>& labels, int outputType)
+{
+    const VoxelFormat* format = voxelFormat(outputType);
+    if(format == nullptr) {
+        return QByteArray();
+    }
+
+    if((qint64)labels.size() * (format->bits / 8) > INT_MAX) {
+        qCritical() << "records of" << labels.size() << "voxels do not fit into a single array";
+        return QByteArray();
+    }
+
+    return format->encode(labels);
+}
+
+QByteArray generateRegion(QList<Object*> objects, Settings* set, Region region, VoxelStats* stats)
+{
+    return encodeRegion(resolveRegion(objects, set, region, stats), set->outputType);
+}
+
+struct Slab {
+    Region region;
+    QList<QByteArray> data;     // one per output type
+    VoxelStats stats;
+};
+
+// splits the slices [z0, z1) into slabs along z, each one is voxelized by a separate thread
+// and the per-thread statistics are reduced afterwards, the data of the slabs is appended to data
+// too few slices (the slabs of the pipeline) are split into runs of rows along x instead, so all the cores get work
+void voxelizeSlabs(QList<Object*> objects, Settings* set, QList<int> outputTypes, int z0, int z1,
+                   QList<QByteArray>& data, VoxelStats* stats, SlabVisitor resolved)
+{
+    int tasks = QThread::idealThreadCount() * 4;
+    int slices = z1 - z0;
+
+    QVector<Slab> slabs;
+    if(slices >= tasks) {
+        slabs.resize(tasks);
+        for(int i = 0; i < tasks; i++) {
+            slabs[i].region = { 0, 0, z0 + slices * i / tasks, set->w, set->h, z0 + slices * (i + 1) / tasks };
+        }
+    } else {
+        // rows of a single slice follow each other in the output (z, then x, then y)
+        int parts = qBound(1, (tasks + slices - 1) / qMax(1, slices), set->w);
+        slabs.resize(slices * parts);
+        for(int z = 0; z < slices; z++) {
+            for(int i = 0; i < parts; i++) {
+                slabs[z * parts + i].region = { set->w * i / parts, 0, z0 + z, set->w * (i + 1) / parts, set->h, z0 + z + 1 };
+            }
+        }
+    }
+
+    // the covering object of every voxel is resolved once and fed to all the encoders
+    QtConcurrent::blockingMap(slabs, [&](Slab& slab) {
+        QVector<Object*> labels = resolveRegion(objects, set, slab.region, &slab.stats);
+        if(resolved) {
+            resolved(slab.region, labels);
+        }
+
+        for(auto type : outputTypes) {
+            slab.data.append(encodeRegion(labels, type));
+        }
+    });
+
+    while(data.size() < outputTypes.size()) {
+        data.append(QByteArray());
+    }
+
+    for(auto& slab : slabs) {
+        for(int i = 0; i < outputTypes.size(); i++) {
+            data[i].append(slab.data[i]);
+        }
+        stats->merge(slab.stats);
+        slab.data.clear();
+    }
+}
+
+QList<QByteArray> generateData(QList<Object*> objects, Settings* set, QList<int> outputTypes, VoxelStats* stats)
+{
+    QList<QByteArray> data;
+
+    stats->reset();
+    voxelizeSlabs(objects, set, outputTypes, 0, set->d, data, stats);
+
+    return data;
+}
+
+// slab of the pipeline, passed from stage to stage
+struct StreamSlab {
+    int z0, z1;
+    QList<QByteArray> data;     // one per output type
+};
+
+bool streamData(QList<Object*> objects, Settings* set, QList<int> outputTypes, QStringList files,
+                VoxelStats* stats, QList<QJsonArray>* chunks)
+{
+    QList<QFile*> outputs;
+    for(auto name : files) {
+        QFile* file = new QFile(name);
+        outputs.append(file);
+
+        // the file may be a hard link into the volume cache, it must not be overwritten in place
+        file->remove();
+
+        if(!file->open(QIODevice::WriteOnly)) {
+            qCritical() << "cannot open" << name;
+            qDeleteAll(outputs);
+            return false;
+        }
+    }
+
+    if(chunks != nullptr) {
+        chunks->clear();
+        for(int i = 0; i < outputTypes.size(); i++) {
+            chunks->append(QJsonArray());
+        }
+    }
+
+    // voxelize -> compress -> write, the stages are connected by bounded queues
+    // so at most 2 * queueDepth + 3 slabs are held in memory at any time
+    BoundedQueue<StreamSlab*> encoded(set->queueDepth);
+    BoundedQueue<StreamSlab*> compressed(set->queueDepth);
+    QAtomicInt failed(0);
+    qint64 compressTime = 0, writeTime = 0;
+
+    QThread* compressor = QThread::create([&]() {
+        QElapsedTimer timer;
+        StreamSlab* slab;
+        while(encoded.pop(slab)) {
+            timer.start();
+            if(set->compression > 0) {
+                for(auto& data : slab->data) {
+                    data = qCompress(data, set->compression);
+                }
+            }
+            compressTime += timer.elapsed();
+
+            compressed.push(slab);
+        }
+        compressed.close();
+    });
+
+    QThread* writer = QThread::create([&]() {
+        QElapsedTimer timer;
+        StreamSlab* slab;
+        // the writer drains the queue even after a failure so the other stages never block
+        while(compressed.pop(slab)) {
+            timer.start();
+            for(int i = 0; i < outputs.size() && !failed.loadAcquire(); i++) {
+                qint64 offset = outputs[i]->pos();
+                if(outputs[i]->write(slab->data[i]) != slab->data[i].size()) {
+                    qCritical() << "cannot write" << outputs[i]->fileName();
+                    failed.storeRelease(1);
+                    break;
+                }
+
+                // compressed slabs are located through the chunk table of the meta file
+                if(chunks != nullptr && set->compression > 0) {
+                    QJsonObject chunk;
+                    chunk["z0"] = slab->z0;
+                    chunk["z1"] = slab->z1;
+                    chunk["offset"] = offset;
+                    chunk["size"] = slab->data[i].size();
+                    (*chunks)[i].append(chunk);
+                }
+            }
+            writeTime += timer.elapsed();
+
+            delete slab;
+        }
+    });
+
+    compressor->start();
+    writer->start();
+
+    // voxelization runs on the calling thread (parallel within the slab),
+    // push() blocks while the slower stages catch up
+    QElapsedTimer timer;
+    timer.start();
+    qint64 voxelizeTime = 0;
+
+    stats->reset();
+    int depth = qMax(1, set->slabDepth);
+    for(int z0 = 0; z0 < set->d && !failed.loadAcquire(); z0 += depth) {
+        QElapsedTimer slabTimer;
+        slabTimer.start();
+
+        StreamSlab* slab = new StreamSlab;
+        slab->z0 = z0;
+        slab->z1 = qMin(z0 + depth, set->d);
+        voxelizeSlabs(objects, set, outputTypes, slab->z0, slab->z1, slab->data, stats);
+
+        voxelizeTime += slabTimer.elapsed();
+        encoded.push(slab);
+    }
+    encoded.close();
+
+    compressor->wait();
+    writer->wait();
+    delete compressor;
+    delete writer;
+
+    for(auto file : outputs) {
+        file->close();
+        qDebug() << "written to: " << QFileInfo(*file).absoluteFilePath();
+    }
+    qDeleteAll(outputs);
+
+    qDebug() << "pipeline:" << timer.elapsed() << "ms (voxelize" << voxelizeTime << "ms, compress"
+             << compressTime << "ms, write" << writeTime << "ms)";
+
+    return !failed.loadAcquire();
+}
+
+QByteArray generateData(QList<Object*> objects, Settings* set, VoxelStats* stats)
+{
+    QList<int> outputTypes;
+    outputTypes.append(set->outputType);
+
+    return generateData(objects, set, outputTypes, stats).first();
+}
+
+QJsonObject computeStats(QList<Object*> objects)
+{
+    QJsonObject stats;
+    QJsonObject global;
+    QJsonObject elements;
+
+    QJsonObject type;
+    int tsc = 0, tbc = 0, tec = 0;
+
+    QJsonObject size;
+    int sc[8];
+    int tssc[8], tbsc[8], tesc[8];
+
+    QJsonObject orientation;
+    int oc[8];
+    int tsoc[8], tboc[8], teoc[8];
+
+    for(int i = 0; i < 8; i++) {
+        sc[i] = oc[i] = 0;
+        tssc[i] = tbsc[i] = tesc[i] = 0;
+        tsoc[i] = tboc[i] = teoc[i] = 0;
+    }
+
+    for(auto o : objects) {
+        switch(o->getType()) {
+            case 1:
+                tsc++;
+                tsoc[o->getOrientation()]++;
+                tssc[o->getSize()]++;
+                break;
+            case 2:
+                tbc++;
+                tboc[o->getOrientation()]++;
+                tbsc[o->getSize()]++;
+                break;
+            case 3:
+                tec++;
+                teoc[o->getOrientation()]++;
+                tesc[o->getSize()]++;
+                break;
+        }
+
+        oc[o->getOrientation()]++;
+        sc[o->getSize()]++;
+    }
+
+    type["Sphere"] = tsc;
+    type["Box"] = tbc;
+    type["Ellipsoid"] = tec;
+    global["Type"] = type;
+
+    for(int i = 0; i < 8; i++) {
+        size["Class " + QString::number(i + 1)] = sc[i];
+    }
+    global["Size"] = size;
+
+    orientation["Random"] = oc[0];
+    orientation["Front"] = oc[1];
+    orientation["Left"] = oc[2];
+    orientation["Up"] = oc[3];
+    orientation["Down"] = oc[4];
+    orientation["Back"] = oc[5];
+    orientation["Diagonal"] = oc[6];
+    orientation["InverseDiagonal"] = oc[7];
+    global["Orientation"] = orientation;
+
+    stats["global"] = global;
+
+    QJsonObject typeS, typeB, typeE;
+    QJsonObject sizeS, sizeB, sizeE;
+    QJsonObject orientationS, orientationB, orientationE;
+
+    // sphere
+    for(int i = 0; i < 8; i++) {
+        sizeS["Class " + QString::number(i + 1)] = tssc[i];
+    }
+
+    orientationS["Random"] = tsoc[0];
+    orientationS["Front"] = tsoc[1];
+    orientationS["Left"] = tsoc[2];
+    orientationS["Up"] = tsoc[3];
+    orientationS["Down"] = tsoc[4];
+    orientationS["Back"] = tsoc[5];
+    orientationS["Diagonal"] = tsoc[6];
+    orientationS["InverseDiagonal"] = tsoc[7];
+
+    typeS["Size"] = sizeS;
+    typeS["Orientation"] = orientationS;
+
+    elements["Sphere"] = typeS;
+
+    // box
+    for(int i = 0; i < 8; i++) {
+        sizeB["Class " + QString::number(i + 1)] = tbsc[i];
+    }
+
+    orientationB["Random"] = tboc[0];
+    orientationB["Front"] = tboc[1];
+    orientationB["Left"] = tboc[2];
+    orientationB["Up"] = tboc[3];
+    orientationB["Down"] = tboc[4];
+    orientationB["Back"] = tboc[5];
+    orientationB["Diagonal"] = tboc[6];
+    orientationB["InverseDiagonal"] = tboc[7];
+
+    typeB["Size"] = sizeB;
+    typeB["Orientation"] = orientationB;
+
+    elements["Box"] = typeB;
+
+    // ellipsoid
+    for(int i = 0; i < 8; i++) {
+        sizeE["Class " + QString::number(i + 1)] = tesc[i];
+    }
+
+    orientationE["Random"] = teoc[0];
+    orientationE["Front"] = teoc[1];
+    orientationE["Left"] = teoc[2];
+    orientationE["Up"] = teoc[3];
+    orientationE["Down"] = teoc[4];
+    orientationE["Back"] = teoc[5];
+    orientationE["Diagonal"] = teoc[6];
+    orientationE["InverseDiagonal"] = teoc[7];
+
+    typeE["Size"] = sizeE;
+    typeE["Orientation"] = orientationE;
+
+    elements["Ellipsoid"] = typeE;
+
+    stats["elements"] = elements;
+
+    return stats;
+}
+
+QString derivedFile(QString file, QString suffix, QString extension)
+{
+    // only a dot after the last slash (and not starting the name) begins the extension, out.v1/data has none
+    int dot = file.lastIndexOf('.');
+    if(dot <= file.lastIndexOf('/') + 1) {
+        dot = file.size();
+    }
+
+    return file.left(dot) + suffix + (extension.isEmpty() ? file.mid(dot) : "." + extension);
+}
+
+QString outputFile(QString targetFile, int outputType)
+{
+    const VoxelFormat* format = voxelFormat(outputType);
+    if(format == nullptr) {
+        return targetFile;
+    }
+
+    return derivedFile(targetFile, format->suffix);
+}
+
+int bitsPerVoxel(int outputType)
+{
+    const VoxelFormat* format = voxelFormat(outputType);
+
+    return format != nullptr ? format->bits : 0;
+}
+
+QJsonObject generateMetaObject(QList<Object*> objects, Settings* set, VoxelStats* stats, QJsonArray chunks)
+{
+    QJsonObject root;
+
+    QJsonObject general;
+    general["info"] = "Binary file contains synthetic volumetric data for VPT renderer.";
+    general["width"] = set->w;
+    general["height"] = set->h;
+    general["depth"] = set->d;
+
+    general["bits"] = bitsPerVoxel(set->outputType);
+
+    general["particles"] = objects.size();
+
+    // slabs compressed by streamData(), each one is a zlib stream prefixed by its
+    // uncompressed size (4 bytes, big endian) as written by qCompress()
+    if(!chunks.isEmpty()) {
+        general["compression"] = "zlib";
+        general["chunks"] = chunks;
+    }
+
+    root["general"] = general;
+    QJsonObject statistics = computeStats(objects);
+    if(stats != nullptr) {
+        statistics["voxels"] = stats->toJson(objects);
+    }
+    root["stats"] = statistics;
+
+    // the layout array is generated from the same description as the encoder
+    const VoxelFormat* format = voxelFormat(set->outputType);
+    QJsonArray layout = format != nullptr ? format->layout() : QJsonArray();
+
+    root["layout"] = layout;
+
+    return root;
+}
+
+QByteArray generateMeta(QList<Object*> objects, Settings* set, VoxelStats* stats, QJsonArray chunks)
+{
+    QJsonDocument doc(generateMetaObject(objects, set, stats, chunks));
+    return doc.toJson();
+}
+
+bool writeData(QByteArray data, Settings* set) {
+
+    // write data into the file
+
+    QFile file(set->targetFile);
+
+    // the file may be a hard link into the volume cache, it must not be overwritten in place
+    file.remove();
+
+    if(!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "cannot open" << set->targetFile;
+        return false;
+    }
+
+    if(file.write(data) != data.size()) {
+        qCritical() << "cannot write" << set->targetFile;
+        return false;
+    }
+
+    file.close();
+
+    qDebug() << "written to: " << QFileInfo(file).absoluteFilePath();
+
+    return true;
+}
@@ -0,0 +1,161 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QList>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+#include "Object.h"
+#include "VoxelStats.h"
+
+// version of the generator output, has to be increased whenever the same settings
+// start producing different data (it is a part of the volume cache key)
+const int GENERATOR_VERSION = 2;
+
+// the most objects of a scene, IDs of the objects are single bytes and 0 is the empty voxel
+const int MAX_OBJECTS = 255;
+
+struct Settings {
+public:
+    // settings
+    int w = 128;                        // grid width
+    int h = 128;                        // grid height
+    int d = 128;                        // grid depth
+    int targetCount = 150;              // how many items do we want in the scene
+    bool canOverlap = false;            // indication whether the objects can overlap
+
+    // 0=random positions on a lattice of 100 steps per axis (tries until targetCount objects fit),
+    // 1=Poisson-disk sampling with continuous positions (stops once the scene is full)
+    int placement = 0;
+
+    // volume fraction of the grid the objects should fill (Poisson-disk placement only, the parts of the objects
+    // reaching out of the grid are not counted), 0=place targetCount objects instead
+    // at most MAX_OBJECTS objects are placed, so small size classes may stop below the fraction
+    float targetFraction = 0.0f;
+
+    // 0=one byte per voxel (value of the voxel),
+    // 1=three bytes per voxel (data structure agreed with Ciril's group) + one byte for padding
+    // 2=five floats per voxel
+    // 3=one byte per voxel (ID of the element, i.e. the label map)
+    int outputType = 1;
+
+    // output types written at once by a single voxelization pass (see generateData()),
+    // empty=outputType only
+    QList<int> outputTypes;
+
+    // pipelined output (see streamData()): slices per slab, slabs waiting between two stages
+    // and zlib level of the slabs (0=uncompressed, the raw file is the same as writeData() gives)
+    bool pipelined = false;
+    int slabDepth = 8;
+    int queueDepth = 2;
+    int compression = 0;
+
+    // seed of the random generator, 0=seeded from the current time
+    // the same seed (and settings) always produces the very same scene
+    uint seed = 0;
+
+    QString targetFile;    // target filename
+
+    // time-series (see generateSequence()): amount of frames (0=single volume) and the largest
+    // drift (grid units), spin (degrees) and growth (relative) of an object per frame
+    int frames = 0;
+    float drift = 0.002f;
+    float spin = 2.0f;
+    float growth = 0.002f;
+
+    // directory of the volume cache (see VolumeCache.h), empty=no cache, and its size in bytes
+    QString cacheDir;
+    qint64 cacheSize = 8LL << 30;
+
+    // what types do we want to include in the generation process (1-sphere, ...)
+    QList<uchar> allowedTypes;
+
+    Settings() {
+        allowedTypes.append(1);
+        allowedTypes.append(2);
+        allowedTypes.append(3);
+
+        targetFile = "data.raw";
+    }
+};
+
+// box of voxels [x0, x1) x [y0, y1) x [z0, z1) of the grid
+struct Region {
+    int x0, y0, z0;
+    int x1, y1, z1;
+
+    inline qint64 voxels() const { return (qint64)(x1 - x0) * (y1 - y0) * (z1 - z0); }
+
+    // part of the region inside the grid, an inverted or outside region becomes empty
+    inline Region clipped(int w, int h, int d) const {
+        Region r;
+        r.x0 = qBound(0, x0, w); r.x1 = qBound(r.x0, x1, w);
+        r.y0 = qBound(0, y0, h); r.y1 = qBound(r.y0, y1, h);
+        r.z0 = qBound(0, z0, d); r.z1 = qBound(r.z0, z1, d);
+        return r;
+    }
+};
+
+// creates the scene, the same settings and seed give the same objects
+QList<Object*> generateObjects(Settings* set);
+
+// voxelizes the whole grid, statistics of the voxels are stored into stats
+QByteArray generateData(QList<Object*> objects, Settings* set, VoxelStats* stats);
+
+// voxelizes the whole grid once and encodes it in all the given output types,
+// the result holds one array per type (in the same order), statistics are stored into stats
+QList<QByteArray> generateData(QList<Object*> objects, Settings* set, QList<int> outputTypes, VoxelStats* stats);
+
+// voxelizes the grid slab by slab and writes the slabs into the files (one per output type) while the next
+// ones are being voxelized and compressed, the memory use is bounded by the queue depth instead of the grid size
+// the chunk tables of the compressed slabs (for generateMeta()) are stored into chunks, returns false on I/O error
+bool streamData(QList<Object*> objects, Settings* set, QList<int> outputTypes, QStringList files,
+                VoxelStats* stats, QList<QJsonArray>* chunks = nullptr);
+
+// called with the covering objects of every slab right after they are resolved (see resolveRegion())
+typedef std::function<void(const Region& region, const QVector<Object*>& covering)> SlabVisitor;
+
+// voxelizes the slices [z0, z1) of the grid and appends them to data (one array per output type), the slices
+// are split into slabs along z or, if there are too few of them, into runs of whole rows along x
+// resolved (if given) is called by the worker threads, a slab starts at the voxel (z0 * w + x0) * h of the grid
+void voxelizeSlabs(QList<Object*> objects, Settings* set, QList<int> outputTypes, int z0, int z1,
+                   QList<QByteArray>& data, VoxelStats* stats, SlabVisitor resolved = nullptr);
+
+// covering object of every voxel of the region (nullptr=empty voxel) in the order of generateRegion() output,
+// the voxel belongs to the first object of the list containing it
+// the region is clipped to the grid first (an inverted, empty or outside region gives no voxels),
+// regions of more than INT_MAX voxels are rejected (empty result)
+QVector<Object*> resolveRegion(QList<Object*> objects, Settings* set, Region region, VoxelStats* stats = nullptr);
+
+// records of the given voxels in the format given by outputType
+QByteArray encodeRegion(const QVector<Object*>& labels, int outputType);
+
+// voxelizes only the given region of the grid, independently of the rest of it
+// the result is byte-identical to the matching part of generateData() output
+// (voxels ordered by z, then x, then y) and the cost depends on the region size only
+QByteArray generateRegion(QList<Object*> objects, Settings* set, Region region, VoxelStats* stats = nullptr);
+
+// bits per voxel of the given output type
+int bitsPerVoxel(int outputType);
+
+// name of a file derived from the given one: the suffix goes before the extension, which is kept
+// unless a new one is given, e.g. data.raw -> data-32b.raw or data-32b.raw -> data-32b.json
+QString derivedFile(QString file, QString suffix, QString extension = QString());
+
+// name of the file of the given output type when more of them are written at once, data.raw -> data-32b.raw
+QString outputFile(QString targetFile, int outputType);
+
+QJsonObject computeStats(QList<Object*> objects);
+
+// meta file descriptor, the voxel statistics are left out if stats is nullptr
+QJsonObject generateMetaObject(QList<Object*> objects, Settings* set, VoxelStats* stats, QJsonArray chunks = QJsonArray());
+QByteArray generateMeta(QList<Object*> objects, Settings* set, VoxelStats* stats, QJsonArray chunks = QJsonArray());
+// writes the data into the target file, returns false if it could not be written whole
+bool writeData(QByteArray data, Settings* set);
+
+#endif // GENERATOR_H
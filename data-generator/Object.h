@@ -58,7 +58,9 @@ public:
     }
 
     inline QVector3D getPosition() { return _position; }
+    inline void setPosition(QVector3D position) { _position = position; }
     inline QQuaternion getRotation() { return _rotation; } // probably not useful
+    inline void setRotation(QQuaternion rotation) { _rotation = rotation; }
 
     // for volumetric data
     inline uchar getId() { return _id; }
@@ -69,6 +71,10 @@ public:
     inline QString getName() { return this->_name; }
 
     virtual bool contains(QVector3D point) = 0;
+    virtual float getBoundingRadius() = 0; // radius of a sphere around the position enclosing the whole object
+    virtual QVector3D getExtents() = 0; // half size of an axis-aligned box around the position enclosing the whole object
+    virtual float getVolume() = 0;
+    virtual void scale(float factor) = 0; // grows (or shrinks) the object around its position
     virtual QList<QVector3D> getBoundingBox() = 0;
 };
 // ===================================
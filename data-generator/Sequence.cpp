@@ -0,0 +1,426 @@
+#include <QVector3D>
+#include <QQuaternion>
+#include <QHash>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+#include "Sequence.h"
+#include "Collisions.h"
+
+// edge of the bricks (in voxels) the grid is split into, only the bricks objects moved through are voxelized again
+const int BRICK = 8;
+
+// random number in [-1, 1)
+static inline float randomSigned()
+{
+    return qrand() / (RAND_MAX + 1.0f) * 2.0f - 1.0f;
+}
+
+static QVector3D randomDirection()
+{
+    QVector3D d;
+    do {
+        d = QVector3D(randomSigned(), randomSigned(), randomSigned());
+    } while(d.lengthSquared() > 1.0f || d.lengthSquared() < 1e-6f);
+
+    return d.normalized();
+}
+
+QVector<Motion> generateMotion(QList<Object*> objects, Settings* set)
+{
+    QVector<Motion> motion;
+
+    for(int i = 0; i < objects.size(); i++) {
+        Motion m;
+        m.velocity = randomDirection() * (randomSigned() * 0.5f + 0.5f) * set->drift;
+        m.spin = QQuaternion::fromAxisAndAngle(randomDirection(), randomSigned() * set->spin);
+        m.growth = 1.0f + randomSigned() * set->growth;
+        motion.append(m);
+    }
+
+    return motion;
+}
+
+// moves the object to the next frame, it bounces off the walls of the grid and off the other objects
+// unless they may overlap (the step is taken back and the motion is reversed)
+static void step(Object* obj, Motion& m, const QList<Object*>& objects, Settings* set)
+{
+    QVector3D position = obj->getPosition();
+    QQuaternion rotation = obj->getRotation();
+
+    QVector3D p = position + m.velocity;
+    for(int a = 0; a < 3; a++) {
+        if(p[a] < 0.0f) {
+            p[a] = -p[a];
+            m.velocity[a] = -m.velocity[a];
+        } else if(p[a] > 1.0f) {
+            p[a] = 2.0f - p[a];
+            m.velocity[a] = -m.velocity[a];
+        }
+    }
+
+    obj->setPosition(p);
+    obj->setRotation(m.spin * rotation);
+    obj->scale(m.growth);
+
+    if(set->canOverlap || !Collisions::collides(obj, objects)) {
+        return;
+    }
+
+    obj->setPosition(position);
+    obj->setRotation(rotation);
+    obj->scale(1.0f / m.growth);
+
+    m.velocity = -m.velocity;
+    m.spin = m.spin.conjugated();
+    m.growth = 1.0f / m.growth;
+}
+
+// bricks reached by the extents of the object (inclusive range)
+static void brickRange(Object* obj, Settings* set, int lo[3], int hi[3])
+{
+    int n[3] = { set->w, set->h, set->d };
+    QVector3D p = obj->getPosition();
+    QVector3D e = obj->getExtents();
+
+    for(int a = 0; a < 3; a++) {
+        // voxel centers (i + 0.5) / n within the extents (small margin covers the rounding in contains())
+        lo[a] = qBound(0, (int)qFloor((p[a] - e[a] - 1e-4f) * n[a] - 0.5f), n[a] - 1) / BRICK;
+        hi[a] = qBound(0, (int)qCeil((p[a] + e[a] + 1e-4f) * n[a] - 0.5f), n[a] - 1) / BRICK;
+    }
+}
+
+// classifies the voxels of the brick against the object: 1=all inside, -1=all outside, 0=mixed
+static int classify(Object* obj, Settings* set, int bx, int by, int bz)
+{
+    int n[3] = { set->w, set->h, set->d };
+    int b[3] = { bx, by, bz };
+
+    // centers of the first and the last voxel of the brick along every axis
+    float lo[3], hi[3];
+    for(int a = 0; a < 3; a++) {
+        lo[a] = (b[a] * BRICK + 0.5f) / n[a];
+        hi[a] = (qMin((b[a] + 1) * BRICK, n[a]) - 0.5f) / n[a];
+    }
+
+    // outside: the brick does not reach into the extents or the bounding sphere
+    QVector3D p = obj->getPosition();
+    QVector3D e = obj->getExtents();
+    float r = obj->getBoundingRadius() + 1e-4f;
+    float distance = 0.0f;
+    for(int a = 0; a < 3; a++) {
+        if(hi[a] < p[a] - e[a] - 1e-4f || lo[a] > p[a] + e[a] + 1e-4f) {
+            return -1;
+        }
+
+        float d = qBound(lo[a], p[a], hi[a]) - p[a];
+        distance += d * d;
+    }
+    if(distance > r * r) {
+        return -1;
+    }
+
+    // inside: the objects are convex, so the brick is inside once all its corners are
+    for(int c = 0; c < 8; c++) {
+        QVector3D corner(c & 1 ? hi[0] : lo[0], c & 2 ? hi[1] : lo[1], c & 4 ? hi[2] : lo[2]);
+        if(!obj->contains(corner)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// data.raw -> data-0001.delta
+static QString frameFile(QString targetFile, int frame, QString suffix)
+{
+    return derivedFile(targetFile, QString("-%1").arg(frame, 4, 10, QChar('0')), suffix);
+}
+
+// transforms of the objects in the frame (ground truth for the reprojection)
+static QJsonArray describeObjects(QList<Object*> objects)
+{
+    QJsonArray list;
+    for(auto o : objects) {
+        QVector3D p = o->getPosition();
+        QQuaternion r = o->getRotation();
+
+        QJsonObject obj;
+        obj["id"] = o->getId();
+        obj["position"] = QJsonArray({ p.x(), p.y(), p.z() });
+        obj["rotation"] = QJsonArray({ r.scalar(), r.x(), r.y(), r.z() });
+        obj["radius"] = o->getBoundingRadius();
+        list.append(obj);
+    }
+
+    return list;
+}
+
+static bool writeFrame(QList<Object*> objects, Settings* set, VoxelStats* stats, int frame,
+                       QByteArray data, QJsonObject desc)
+{
+    Settings out = *set;
+    out.targetFile = frameFile(set->targetFile, frame, frame == 0 ? "raw" : "delta");
+    if(!writeData(data, &out)) {
+        return false;
+    }
+
+    desc["index"] = frame;
+    desc["frames"] = set->frames;
+    desc["delta"] = frame > 0;
+    desc["objects"] = describeObjects(objects);
+
+    QJsonObject root = generateMetaObject(objects, set, stats);
+    root["frame"] = desc;
+
+    // the delta is not a volume of width x height x depth records, readers of plain volumes have to refuse it
+    if(frame > 0) {
+        QJsonObject general = root["general"].toObject();
+        general["delta"] = true;
+        root["general"] = general;
+    }
+
+    out.targetFile = frameFile(set->targetFile, frame, "json");
+    return writeData(QJsonDocument(root).toJson(), &out);
+}
+
+// label of the voxel covered by the object (index of the object + 1, 0=empty voxel)
+// neighbouring voxels are mostly covered by the same object, so the last lookup is kept
+class Labeler {
+private:
+    const QHash<Object*, quint16>& _index;
+    Object* _last = nullptr;
+    quint16 _label = 0;
+
+public:
+    explicit Labeler(const QHash<Object*, quint16>& index) : _index(index) {}
+
+    inline quint16 operator()(Object* obj) {
+        if(obj != _last) {
+            _last = obj;
+            _label = obj != nullptr ? _index.value(obj) : 0;
+        }
+
+        return _label;
+    }
+};
+
+// brick of a delta frame voxelized by a single thread
+struct Brick {
+    Region region;
+    QByteArray data;            // records of the changed voxels
+
+    // runs of changed voxels
+    QVector<quint32> starts;
+    QVector<quint32> counts;
+};
+
+// run of changed voxels, the records are taken from the brick at the given offset
+struct Run {
+    quint32 start;
+    quint32 count;
+    int brick;
+    qint64 offset;
+
+    bool operator<(const Run& other) const { return start < other.start; }
+};
+
+bool generateSequence(QList<Object*> objects, Settings* set, VoxelStats* stats)
+{
+    int recordBytes = bitsPerVoxel(set->outputType) / 8;
+    if(recordBytes == 0) {
+        qCritical() << "unknown output type" << set->outputType;
+        return false;
+    }
+
+    // the labels and the first frame are held whole in memory, both are limited to INT_MAX elements
+    qint64 voxels = (qint64)set->w * set->h * set->d;
+    if(voxels > INT_MAX / recordBytes || objects.size() >= 0xffff) {
+        qCritical() << "time-series of this output type is limited to" << INT_MAX / recordBytes << "voxels (frames of INT_MAX bytes) and 65535 objects";
+        return false;
+    }
+
+    // labels of the previous frame (index of the object + 1, 0=empty voxel), voxels ordered by z, then x, then y
+    QVector<quint16> labels(voxels);
+    QHash<Object*, quint16> index;
+    for(int i = 0; i < objects.size(); i++) {
+        index[objects[i]] = i + 1;
+    }
+
+    QVector<Motion> motion = generateMotion(objects, set);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the first frame is voxelized as a whole, the labels are filled in as the slabs are resolved
+    QList<QByteArray> data;
+    stats->reset();
+    voxelizeSlabs(objects, set, QList<int>() << set->outputType, 0, set->d, data, stats,
+                  [&](const Region& region, const QVector<Object*>& covering) {
+        Labeler labeler(index);
+        quint16* l = labels.data() + ((qint64)region.z0 * set->w + region.x0) * set->h;
+        for(auto obj : covering) {
+            *l++ = labeler(obj);
+        }
+    });
+
+    qDebug() << "frame 0:" << timer.elapsed() << "ms";
+    if(!writeFrame(objects, set, stats, 0, data[0], QJsonObject())) {
+        return false;
+    }
+
+    int bricksX = (set->w + BRICK - 1) / BRICK;
+    int bricksY = (set->h + BRICK - 1) / BRICK;
+    int bricksZ = (set->d + BRICK - 1) / BRICK;
+
+    for(int frame = 1; frame < set->frames; frame++) {
+        timer.start();
+
+        // a brick has to be voxelized again unless every object which moved covers it entirely
+        // or misses it entirely both before and after the step
+        QVector<bool> dirty(bricksX * bricksY * bricksZ, false);
+        QVector<qint8> before;
+        for(int i = 0; i < objects.size(); i++) {
+            Object* obj = objects[i];
+
+            int lo0[3], hi0[3];
+            brickRange(obj, set, lo0, hi0);
+
+            int sx = hi0[0] - lo0[0] + 1, sy = hi0[1] - lo0[1] + 1, sz = hi0[2] - lo0[2] + 1;
+            before.resize(sx * sy * sz);
+            for(int j = 0; j < before.size(); j++) {
+                before[j] = classify(obj, set, lo0[0] + j % sx, lo0[1] + j / sx % sy, lo0[2] + j / (sx * sy));
+            }
+
+            step(obj, motion[i], objects, set);
+
+            int lo1[3], hi1[3];
+            brickRange(obj, set, lo1, hi1);
+
+            for(int bz = qMin(lo0[2], lo1[2]); bz <= qMax(hi0[2], hi1[2]); bz++) {
+                for(int by = qMin(lo0[1], lo1[1]); by <= qMax(hi0[1], hi1[1]); by++) {
+                    for(int bx = qMin(lo0[0], lo1[0]); bx <= qMax(hi0[0], hi1[0]); bx++) {
+                        bool in0 = bx >= lo0[0] && bx <= hi0[0] && by >= lo0[1] && by <= hi0[1] && bz >= lo0[2] && bz <= hi0[2];
+                        bool in1 = bx >= lo1[0] && bx <= hi1[0] && by >= lo1[1] && by <= hi1[1] && bz >= lo1[2] && bz <= hi1[2];
+
+                        int c0 = in0 ? before[((bz - lo0[2]) * sy + (by - lo0[1])) * sx + (bx - lo0[0])] : -1;
+                        int c1 = in1 ? classify(obj, set, bx, by, bz) : -1;
+                        if(c0 != c1 || c0 == 0) {
+                            dirty[(bz * bricksY + by) * bricksX + bx] = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        QVector<Brick> bricks;
+        for(int bz = 0; bz < bricksZ; bz++) {
+            for(int by = 0; by < bricksY; by++) {
+                for(int bx = 0; bx < bricksX; bx++) {
+                    if(dirty[(bz * bricksY + by) * bricksX + bx]) {
+                        Brick brick;
+                        brick.region = { bx * BRICK, by * BRICK, bz * BRICK,
+                                         qMin((bx + 1) * BRICK, set->w), qMin((by + 1) * BRICK, set->h), qMin((bz + 1) * BRICK, set->d) };
+                        bricks.append(brick);
+                    }
+                }
+            }
+        }
+
+        // the bricks are voxelized again and compared with the previous frame, every brick by a single thread
+        // (the bricks do not overlap, so the labels are updated in place)
+        QtConcurrent::blockingMap(bricks, [&](Brick& brick) {
+            QVector<Object*> covering = resolveRegion(objects, set, brick.region);
+            QVector<Object*> changed;
+            Labeler labeler(index);
+
+            const Region& r = brick.region;
+            int i = 0;
+            for(int z = r.z0; z < r.z1; z++) {
+                for(int x = r.x0; x < r.x1; x++) {
+                    quint32 row = ((quint32)z * set->w + x) * set->h;
+
+                    for(int y = r.y0; y < r.y1; y++, i++) {
+                        Object* obj = covering[i];
+                        quint16 label = labeler(obj);
+                        if(labels[row + y] == label) {
+                            continue;
+                        }
+
+                        labels[row + y] = label;
+                        changed.append(obj);
+
+                        // changed voxels following each other along y form a run
+                        if(!brick.starts.isEmpty() && brick.starts.last() + brick.counts.last() == row + y) {
+                            brick.counts.last()++;
+                        } else {
+                            brick.starts.append(row + y);
+                            brick.counts.append(1);
+                        }
+                    }
+                }
+            }
+
+            brick.data = encodeRegion(changed, set->outputType);
+        });
+
+        // runs ordered by the voxel index, each one is its header followed by the records of its voxels
+        QVector<Run> runs;
+        qint64 voxelized = 0;
+        for(int b = 0; b < bricks.size(); b++) {
+            qint64 offset = 0;
+            for(int i = 0; i < bricks[b].starts.size(); i++) {
+                Run run = { bricks[b].starts[i], bricks[b].counts[i], b, offset };
+                runs.append(run);
+                offset += (qint64)run.count * recordBytes;
+            }
+            voxelized += bricks[b].region.voxels();
+        }
+        std::sort(runs.begin(), runs.end());
+
+        // the runs of a brick end at its edge, runs of the neighbouring bricks continuing them are merged
+        QByteArray delta;
+        qint64 changed = 0;
+        int merged = 0;
+        int header = -1;            // offset of the header of the last run in the delta
+        quint32 start = 0, end = 0; // voxels of the last run
+        for(auto& run : runs) {
+            if(header >= 0 && run.start == end) {
+                qToBigEndian<quint32>(end + run.count - start, (uchar*)delta.data() + header + 4);
+            } else {
+                start = run.start;
+                uchar bytes[8];
+                qToBigEndian<quint32>(run.start, bytes);
+                qToBigEndian<quint32>(run.count, bytes + 4);
+                header = delta.size();
+                delta.append((const char*)bytes, sizeof(bytes));
+                merged++;
+            }
+            delta.append(bricks[run.brick].data.constData() + run.offset, run.count * recordBytes);
+            end = run.start + run.count;
+            changed += run.count;
+        }
+
+        qDebug() << "frame" << frame << ":" << changed << "voxels changed," << voxelized << "voxelized in" << timer.elapsed() << "ms";
+
+        QJsonObject desc;
+        desc["base"] = frame - 1;
+        desc["changed"] = changed;
+        desc["runs"] = merged;
+        desc["voxelized"] = voxelized;
+        desc["encoding"] = "runs of changed voxels: index of the first voxel (32 bits) and amount of the voxels (32 bits), "
+                           "both big endian, followed by the records of the voxels";
+        if(!writeFrame(objects, set, nullptr, frame, delta, desc)) {
+            return false;
+        }
+    }
+
+    return true;
+}
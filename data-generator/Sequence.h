@@ -0,0 +1,27 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <QList>
+#include <QVector>
+#include <QVector3D>
+#include <QQuaternion>
+
+#include "Generator.h"
+
+// motion of an object between two frames
+struct Motion {
+    QVector3D velocity;     // grid units per frame
+    QQuaternion spin;       // rotation per frame
+    float growth;           // scale factor per frame
+};
+
+// random motion of every object, limited by the drift, spin and growth of the settings
+QVector<Motion> generateMotion(QList<Object*> objects, Settings* set);
+
+// writes set->frames frames of the animated scene in the format given by set->outputType,
+// the first frame is a full volume (data.raw -> data-0000.raw), every next one is a sparse delta against
+// the previous frame (data-0001.delta), each frame has its meta file (data-0001.json) holding the frame index
+// only the bricks the objects moved through are voxelized again, returns false on error
+bool generateSequence(QList<Object*> objects, Settings* set, VoxelStats* stats);
+
+#endif // SEQUENCE_H
@@ -5,6 +5,7 @@
 #include <QDebug>
 #include <QQuaternion>
 #include <QSizeF>
+#include <QtMath>
 
 #include "Object.h"
 #include "Collisions.h"
@@ -51,6 +52,22 @@ public:
         return d < this->_radius;
     }
 
+    inline float getBoundingRadius() override {
+        return this->_radius;
+    }
+
+    inline QVector3D getExtents() override {
+        return QVector3D(this->_radius, this->_radius, this->_radius);
+    }
+
+    inline float getVolume() override {
+        return 4.0f / 3.0f * (float)M_PI * this->_radius * this->_radius * this->_radius;
+    }
+
+    inline void scale(float factor) override {
+        this->_radius *= factor;
+    }
+
     inline QList<QVector3D> getBoundingBox() override {
         QList<QVector3D> list;
 
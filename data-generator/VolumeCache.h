@@ -0,0 +1,238 @@
+#ifndef VOLUMECACHE_H
+#define VOLUMECACHE_H
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "Generator.h"
+
+// content-addressed cache of generated volumes, every entry is a directory named by the key
+// of the settings holding the raw and meta files, the entries are published atomically (rename of
+// a complete directory) and the least recently used ones are evicted once the cache exceeds its size
+// the files are stored under canonical names (0.raw, 0.json, 1.raw, ... in the order of the output types),
+// so the names of the targets are not a part of the key, they are mapped to the targets by fetch() only
+// the files are handed out as hard links (copies where links are not possible) or can be mapped directly (path())
+class VolumeCache {
+private:
+    QString _dir;
+    qint64 _maxBytes;
+
+public:
+    VolumeCache(QString dir, qint64 maxBytes) : _dir(dir), _maxBytes(maxBytes) {
+        QDir().mkpath(dir);
+    }
+
+    // key of everything the output depends on, settings seeded by the time (seed 0) cannot be cached
+    static QString key(Settings* set, QList<int> outputTypes) {
+        if(set->seed == 0) {
+            return QString();
+        }
+
+        QJsonArray types, allowed;
+        for(auto t : outputTypes) {
+            types.append(t);
+        }
+        for(auto t : set->allowedTypes) {
+            allowed.append(t);
+        }
+
+        QJsonObject desc;
+        desc["version"] = GENERATOR_VERSION;
+        desc["w"] = set->w;
+        desc["h"] = set->h;
+        desc["d"] = set->d;
+        desc["targetCount"] = set->targetCount;
+        desc["canOverlap"] = set->canOverlap;
+        desc["placement"] = set->placement;
+        desc["targetFraction"] = set->targetFraction;
+        desc["seed"] = (qint64)set->seed;
+        desc["allowedTypes"] = allowed;
+        desc["outputTypes"] = types;
+
+        // the chunks of the compressed output depend on the slabs
+        desc["compression"] = set->pipelined ? set->compression : 0;
+        desc["slabDepth"] = set->pipelined && set->compression > 0 ? set->slabDepth : 0;
+
+        // keys of QJsonObject are sorted, so the document is canonical
+        QByteArray json = QJsonDocument(desc).toJson(QJsonDocument::Compact);
+        return QCryptographicHash::hash(json, QCryptographicHash::Sha256).toHex();
+    }
+
+    // canonical names of the raw and meta file of the output type with the given index
+    static QString rawName(int index) { return QString("%1.raw").arg(index); }
+    static QString metaName(int index) { return QString("%1.json").arg(index); }
+
+    // path of the cached file, e.g. to map it instead of linking
+    QString path(QString key, QString name) const {
+        return _dir + "/" + key + "/" + name;
+    }
+
+    bool contains(QString key) const {
+        return !key.isEmpty() && QFileInfo(_dir + "/" + key).isDir();
+    }
+
+    // makes the cached files of the entry available under the target names (one raw and meta file per output type),
+    // the targets are left untouched unless the entry holds all of them
+    bool fetch(QString key, QStringList files, QStringList metas) {
+        if(!complete(key, files.size())) {
+            return false;
+        }
+
+        for(int i = 0; i < files.size(); i++) {
+            if(!place(path(key, rawName(i)), files[i]) || !place(path(key, metaName(i)), metas[i])) {
+                return false;
+            }
+        }
+
+        touch(key);
+        qDebug() << "cache hit:" << key;
+
+        return true;
+    }
+
+    // stores the generated files as a new entry, nothing happens if another process published it first
+    bool publish(QString key, QStringList files, QStringList metas) {
+        if(key.isEmpty()) {
+            return false;
+        }
+
+        // the entry is completed in a temporary directory and renamed at once
+        QString tmp = QString("%1/.tmp-%2-%3").arg(_dir).arg(key).arg(QCoreApplication::applicationPid());
+        QDir(tmp).removeRecursively();
+        QDir().mkpath(tmp);
+
+        for(int i = 0; i < files.size(); i++) {
+            if(!place(files[i], tmp + "/" + rawName(i)) || !place(metas[i], tmp + "/" + metaName(i))) {
+                QDir(tmp).removeRecursively();
+                return false;
+            }
+        }
+
+        writeStamp(tmp);
+
+        // an incomplete entry (e.g. damaged by hand) would never be hit, it is replaced
+        QString entry = _dir + "/" + key;
+        if(contains(key) && !complete(key, files.size())) {
+            QDir(entry).removeRecursively();
+        }
+
+        if(!QDir().rename(tmp, entry)) {
+            QDir(tmp).removeRecursively();
+            return complete(key, files.size());
+        }
+
+        qDebug() << "cached as:" << key;
+        evict(key);
+
+        return true;
+    }
+
+    // removes the least recently used entries until the cache fits into its size, keep is never removed
+    void evict(QString keep = QString()) {
+        struct Entry {
+            QString name;
+            qint64 used;
+            qint64 bytes;
+        };
+
+        QList<Entry> entries;
+        qint64 total = 0;
+        for(auto info : QDir(_dir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            if(info.fileName().startsWith(".")) {
+                continue;
+            }
+
+            Entry e;
+            e.name = info.fileName();
+            e.used = readStamp(info.filePath());
+            e.bytes = 0;
+            for(auto file : QDir(info.filePath()).entryInfoList(QDir::Files)) {
+                e.bytes += file.size();
+            }
+
+            total += e.bytes;
+            entries.append(e);
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+
+        for(auto& e : entries) {
+            if(total <= _maxBytes) {
+                break;
+            }
+
+            if(e.name != keep) {
+                QDir(_dir + "/" + e.name).removeRecursively();
+                total -= e.bytes;
+                qDebug() << "evicted:" << e.name;
+            }
+        }
+    }
+
+private:
+    // the entry holds the raw and meta files of all the output types
+    bool complete(QString key, int count) const {
+        if(!contains(key)) {
+            return false;
+        }
+
+        for(int i = 0; i < count; i++) {
+            if(!QFileInfo(path(key, rawName(i))).isFile() || !QFileInfo(path(key, metaName(i))).isFile()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // the stamp holds the time of the last use of the entry (more reliable than the access time of the files)
+    void touch(QString key) {
+        writeStamp(_dir + "/" + key);
+    }
+
+    static void writeStamp(QString dir) {
+        QFile stamp(dir + "/used");
+        if(stamp.open(QIODevice::WriteOnly)) {
+            stamp.write(QByteArray::number(QDateTime::currentMSecsSinceEpoch()));
+            stamp.close();
+        }
+    }
+
+    static qint64 readStamp(QString dir) {
+        QFile stamp(dir + "/used");
+        if(!stamp.open(QIODevice::ReadOnly)) {
+            return 0;
+        }
+
+        return stamp.readAll().toLongLong();
+    }
+
+    // hard link of the file, copy if the link is not possible (other file system, no support)
+    static bool place(QString source, QString target) {
+        QFile::remove(target);
+
+#ifdef Q_OS_UNIX
+        if(::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0) {
+            return true;
+        }
+#endif
+
+        return QFile::copy(source, target);
+    }
+};
+
+#endif // VOLUMECACHE_H
@@ -0,0 +1,252 @@
+#ifndef VOXELLAYOUT_H
+#define VOXELLAYOUT_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtEndian>
+#include <cstring>
+
+#include "Object.h"
+
+// declarative description of the voxel records
+// a layout is a Record of encoded fields, the same type gives the layout array of the meta file (describe())
+// and the encoder writing the records straight into the output buffer (write()), both are resolved at compile time
+// the empty voxel is all zeros in every layout
+
+// fields of the object covering the voxel
+
+struct TypeField {
+    static const char* name() { return "Type"; }
+    static const char* desc() { return "Type of the element"; }
+    static QJsonArray values() { return { "Undefined", "Sphere", "Ellipsoid", "Box" }; }
+    static inline uchar get(Object* o) { return o->getType(); }
+};
+
+struct SizeField {
+    static const char* name() { return "Size"; }
+    static const char* desc() { return "Size of the element"; }
+    static QJsonArray values() {
+        return { "Class 1", "Class 2", "Class 3", "Class 4", "Class 5", "Class 6", "Class 7", "Class 8" };
+    }
+    static inline uchar get(Object* o) { return o->getSize(); }
+};
+
+struct OrientationField {
+    static const char* name() { return "Orientation"; }
+    static const char* desc() { return "Orientation of the element"; }
+    static QJsonArray values() {
+        return { "Random", "Front", "Left", "Up", "Down", "Back", "Diagonal", "InverseDiagonal" };
+    }
+    static inline uchar get(Object* o) { return o->getOrientation(); }
+};
+
+struct IdField {
+    static const char* name() { return "ID"; }
+    static const char* desc() { return "ID of the element presented in the current cell."; }
+    static QJsonArray values() { return QJsonArray(); }
+    static inline uchar get(Object* o) { return o->getId(); }
+};
+
+struct ValueField {
+    static const char* name() { return "Value"; }
+    static const char* desc() { return "Value of the element presented in the current cell."; }
+    static QJsonArray values() { return QJsonArray(); }
+    static inline uchar get(Object* o) { return o->getValue(); }
+};
+
+struct PaddingField {
+    static const char* name() { return "Padding"; }
+    static const char* desc() { return "Zeros used for padding."; }
+    static QJsonArray values() { return QJsonArray(); }
+    static inline uchar get(Object*) { return 0; }
+};
+
+struct HeaderField {
+    static const char* name() { return "Header"; }
+    static const char* desc() { return "Header byte of a cell."; }
+    static QJsonArray values() { return QJsonArray(); }
+};
+
+// entry of the layout array
+template<typename F>
+QJsonObject describeField(int bits, const char* datatype)
+{
+    QJsonObject field;
+    field["name"] = F::name();
+    field["bits"] = bits;
+    field["datatype"] = datatype;
+    field["desc"] = F::desc();
+
+    QJsonArray values = F::values();
+    if(!values.isEmpty()) {
+        field["values"] = values;
+    }
+
+    return field;
+}
+
+// encodings of the fields
+
+// one byte
+template<typename F>
+struct UInt8 {
+    static const int bits = 8;
+
+    static inline void write(uchar* dst, Object* o) { dst[0] = F::get(o); }
+    static QJsonObject describe() { return describeField<F>(bits, "byte"); }
+};
+
+// 32-bit float, big endian (the same as QDataStream writes it)
+template<typename F>
+struct Float32 {
+    static const int bits = 32;
+
+    static inline void write(uchar* dst, Object* o) {
+        float f = F::get(o);
+        quint32 u;
+        memcpy(&u, &f, sizeof(u));
+        qToBigEndian<quint32>(u, dst);
+    }
+    static QJsonObject describe() { return describeField<F>(bits, "float"); }
+};
+
+// bit-field of a Complex byte
+template<typename F, int N>
+struct Bits {
+    static const int bits = N;
+
+    static inline uchar get(Object* o) { return F::get(o) & ((1 << N) - 1); }
+    static QJsonObject describe() { return describeField<F>(bits, "enum"); }
+};
+
+// bit-fields packed from the most significant bit
+template<typename... B>
+struct BitFields;
+
+template<>
+struct BitFields<> {
+    static const int bits = 0;
+
+    static inline uchar pack(Object*) { return 0; }
+    static inline void describe(QJsonArray&) {}
+};
+
+template<typename B, typename... R>
+struct BitFields<B, R...> {
+    static const int bits = B::bits + BitFields<R...>::bits;
+
+    static inline uchar pack(Object* o) { return (B::get(o) << BitFields<R...>::bits) | BitFields<R...>::pack(o); }
+    static inline void describe(QJsonArray& layout) {
+        layout.append(B::describe());
+        BitFields<R...>::describe(layout);
+    }
+};
+
+// byte made of bit-fields
+template<typename F, typename... B>
+struct Complex {
+    static const int bits = 8;
+    static_assert(BitFields<B...>::bits == 8, "bit-fields of a complex byte have to take 8 bits");
+
+    static inline void write(uchar* dst, Object* o) { dst[0] = BitFields<B...>::pack(o); }
+    static QJsonObject describe() {
+        QJsonArray layout;
+        BitFields<B...>::describe(layout);
+
+        QJsonObject field = describeField<F>(bits, "complex");
+        field["layout"] = layout;
+        return field;
+    }
+};
+
+// record of the voxel, the encoded fields follow each other without gaps
+template<typename... E>
+struct Record;
+
+template<>
+struct Record<> {
+    static const int bits = 0;
+
+    static inline void write(uchar*, Object*) {}
+    static inline void describe(QJsonArray&) {}
+};
+
+template<typename E, typename... R>
+struct Record<E, R...> {
+    static const int bits = E::bits + Record<R...>::bits;
+    static_assert(E::bits % 8 == 0, "fields of a record have to be byte aligned");
+
+    static inline void write(uchar* dst, Object* o) {
+        E::write(dst, o);
+        Record<R...>::write(dst + E::bits / 8, o);
+    }
+    static inline void describe(QJsonArray& layout) {
+        layout.append(E::describe());
+        Record<R...>::describe(layout);
+    }
+};
+
+// layouts of the output types
+
+// 0=value of the voxel
+typedef Record<UInt8<ValueField>> ValueLayout;
+
+// 1=header byte (type, size, orientation), ID, value and padding
+typedef Record<Complex<HeaderField, Bits<TypeField, 2>, Bits<SizeField, 3>, Bits<OrientationField, 3>>,
+               UInt8<IdField>, UInt8<ValueField>, UInt8<PaddingField>> PackedLayout;
+
+// 2=five floats
+typedef Record<Float32<TypeField>, Float32<SizeField>, Float32<OrientationField>, Float32<IdField>, Float32<ValueField>> FloatLayout;
+
+// 3=ID of the element (label map)
+typedef Record<UInt8<IdField>> LabelLayout;
+
+// encodes the voxels covered by the given objects (nullptr=empty voxel) into the records of the layout
+template<typename L>
+QByteArray encodeRecords(const QVector<Object*>& labels)
+{
+    const int bytes = L::bits / 8;
+
+    // the buffer starts zeroed, so only the occupied voxels are written
+    QByteArray data(labels.size() * bytes, 0);
+    uchar* dst = (uchar*)data.data();
+
+    for(auto obj : labels) {
+        if(obj != nullptr) {
+            L::write(dst, obj);
+        }
+        dst += bytes;
+    }
+
+    return data;
+}
+
+template<typename L>
+QJsonArray describeRecord()
+{
+    QJsonArray layout;
+    L::describe(layout);
+    return layout;
+}
+
+// output type resolved once per region instead of once per voxel
+struct VoxelFormat {
+    int bits;
+    const char* suffix;         // of the file name when more output types are written at once, data.raw -> data-32b.raw
+    QByteArray (*encode)(const QVector<Object*>& labels);
+    QJsonArray (*layout)();
+
+    template<typename L>
+    static VoxelFormat of(const char* suffix) {
+        VoxelFormat format;
+        format.bits = L::bits;
+        format.suffix = suffix;
+        format.encode = &encodeRecords<L>;
+        format.layout = &describeRecord<L>;
+        return format;
+    }
+};
+
+#endif // VOXELLAYOUT_H
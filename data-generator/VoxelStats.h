@@ -0,0 +1,138 @@
+#ifndef VOXELSTATS_H
+#define VOXELSTATS_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtGlobal>
+#include <climits>
+
+#include "Object.h"
+
+// statistics gathered while voxelizing the scene
+// every thread fills its own instance which are merged together afterwards
+class VoxelStats {
+public:
+    qint64 total;                       // amount of voxels visited
+    qint64 histogram[256];              // histogram of the voxel values (0 for empty voxels)
+    qint64 typeCount[4];                // voxels per type (0=undefined/empty, 1=sphere, 2=ellipsoid, 3=box)
+    qint64 idCount[256];                // voxels per object ID (0=empty)
+    int boundsMin[256][3];              // tight voxel bounding box per object ID (inclusive)
+    int boundsMax[256][3];
+
+    VoxelStats() {
+        reset();
+    }
+
+    void reset() {
+        total = 0;
+
+        for(int i = 0; i < 256; i++) {
+            histogram[i] = 0;
+            idCount[i] = 0;
+
+            for(int j = 0; j < 3; j++) {
+                boundsMin[i][j] = INT_MAX;
+                boundsMax[i][j] = INT_MIN;
+            }
+        }
+
+        for(int i = 0; i < 4; i++) {
+            typeCount[i] = 0;
+        }
+    }
+
+    inline void add(int x, int y, int z, Object* obj) {
+        total++;
+
+        if(obj == nullptr) {
+            histogram[0]++;
+            typeCount[0]++;
+            idCount[0]++;
+            return;
+        }
+
+        uchar id = obj->getId();
+
+        histogram[obj->getValue()]++;
+        typeCount[obj->getType() & 3]++;
+        idCount[id]++;
+
+        int p[3] = { x, y, z };
+        for(int j = 0; j < 3; j++) {
+            boundsMin[id][j] = qMin(boundsMin[id][j], p[j]);
+            boundsMax[id][j] = qMax(boundsMax[id][j], p[j]);
+        }
+    }
+
+    void merge(const VoxelStats& other) {
+        total += other.total;
+
+        for(int i = 0; i < 256; i++) {
+            histogram[i] += other.histogram[i];
+            idCount[i] += other.idCount[i];
+
+            for(int j = 0; j < 3; j++) {
+                boundsMin[i][j] = qMin(boundsMin[i][j], other.boundsMin[i][j]);
+                boundsMax[i][j] = qMax(boundsMax[i][j], other.boundsMax[i][j]);
+            }
+        }
+
+        for(int i = 0; i < 4; i++) {
+            typeCount[i] += other.typeCount[i];
+        }
+    }
+
+    QJsonObject toJson(QList<Object*> objects) const {
+        QJsonObject voxels;
+
+        qint64 occupied = total - typeCount[0];
+
+        voxels["total"] = total;
+        voxels["occupied"] = occupied;
+        voxels["volumeFraction"] = total > 0 ? (double)occupied / total : 0.0;
+
+        QJsonArray hist;
+        for(int i = 0; i < 256; i++) {
+            hist.append(histogram[i]);
+        }
+        voxels["histogram"] = hist;
+
+        QJsonObject type;
+        type["Undefined"] = typeCount[0];
+        type["Sphere"] = typeCount[1];
+        type["Ellipsoid"] = typeCount[2];
+        type["Box"] = typeCount[3];
+        voxels["Type"] = type;
+
+        // objects hidden by others (or lying outside the grid) have zero voxels and no bounding box
+        QJsonArray elements;
+        for(auto o : objects) {
+            uchar id = o->getId();
+
+            QJsonObject element;
+            element["id"] = id;
+            element["name"] = o->getName();
+            element["voxels"] = idCount[id];
+
+            if(idCount[id] > 0) {
+                QJsonArray bmin, bmax;
+                for(int j = 0; j < 3; j++) {
+                    bmin.append(boundsMin[id][j]);
+                    bmax.append(boundsMax[id][j]);
+                }
+
+                QJsonObject bounds;
+                bounds["min"] = bmin;
+                bounds["max"] = bmax;
+                element["bounds"] = bounds;
+            }
+
+            elements.append(element);
+        }
+        voxels["elements"] = elements;
+
+        return voxels;
+    }
+};
+
+#endif // VOXELSTATS_H
@@ -1,4 +1,4 @@
-QT += core gui opengl
+QT += core gui opengl concurrent
 
 CONFIG += c++11 console
 CONFIG -= app_bundle
@@ -15,6 +15,8 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        Generator.cpp \
+        Sequence.cpp \
         main.cpp
 
 # Default rules for deployment.
@@ -23,11 +25,17 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
+    BoundedQueue.h \
     Box.h \
     Collisions.h \
     Ellipsoid.h \
+    Generator.h \
     Object.h \
-    Sphere.h
+    Sequence.h \
+    Sphere.h \
+    VolumeCache.h \
+    VoxelLayout.h \
+    VoxelStats.h
 
 DISTFILES += \
     metadata.json
@@ -0,0 +1,158 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtGlobal>
+#include <cstring>
+
+// one field of the voxel record as described by the layout array of the meta file
+struct Channel {
+    QString name;
+    QString datatype;   // byte, enum, complex, float
+    int offset;         // bit offset from the start of the record, the most significant bit first
+    int bits;
+    int depth;          // 0=top level field, 1=bit-field of a complex field, ...
+    bool isFloat;
+
+    // raw bits of the field in the given record
+    inline quint32 raw(const uchar* record) const {
+        // fast path for the byte aligned bytes
+        if(bits == 8 && (offset & 7) == 0) {
+            return record[offset >> 3];
+        }
+
+        int first = offset >> 3;
+        int last = (offset + bits - 1) >> 3;
+
+        quint64 v = 0;
+        for(int i = first; i <= last; i++) {
+            v = (v << 8) | record[i];
+        }
+
+        int shift = (last + 1) * 8 - (offset + bits);
+        return (quint32)((v >> shift) & ((1ULL << bits) - 1));
+    }
+
+    // histogram bin [0, 255] of the field in the given record
+    // floats are stored in the big endian order (QDataStream default) so raw() gives their bits
+    inline int bin(const uchar* record) const {
+        quint32 r = raw(record);
+
+        if(isFloat) {
+            float f;
+            memcpy(&f, &r, sizeof(f));
+            return f >= 0.0f && f <= 255.0f ? (int)f : (f > 255.0f ? 255 : 0); // NaN goes to 0
+        }
+
+        return bits > 8 ? (int)(r >> (bits - 8)) : (int)r;
+    }
+};
+
+// layout of the voxel record, i.e. the general section and the layout array of the meta file
+// written by generateMeta() of the data-generator
+class Layout {
+public:
+    int width = 0;
+    int height = 0;
+    int depth = 0;
+    int bits = 0;
+
+    QList<Channel> channels;
+    QString error;
+
+    inline int recordBytes() const { return bits / 8; }
+    inline qint64 voxels() const { return (qint64)width * height * depth; }
+    inline qint64 expectedSize() const { return voxels() * recordBytes(); }
+
+    int indexOf(QString name) const {
+        for(int i = 0; i < channels.size(); i++) {
+            if(channels[i].name.toLower() == name.toLower()) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    bool parse(QJsonObject root) {
+        QJsonObject general = root["general"].toObject();
+        width = general["width"].toInt();
+        height = general["height"].toInt();
+        depth = general["depth"].toInt();
+        bits = general["bits"].toInt();
+
+        if(width <= 0 || height <= 0 || depth <= 0) {
+            error = "invalid dimensions in the general section";
+            return false;
+        }
+
+        if(bits <= 0 || bits % 8 != 0) {
+            error = QString("record of %1 bits is not a whole number of bytes").arg(bits);
+            return false;
+        }
+
+        int used = parseFields(root["layout"].toArray(), 0, 0);
+        if(used < 0) {
+            return false;
+        }
+
+        if(used != bits) {
+            error = QString("layout describes %1 bits but the general section declares %2").arg(used).arg(bits);
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    // appends the fields starting at the given bit offset, returns the amount of bits they take (-1 on error)
+    int parseFields(QJsonArray fields, int offset, int level) {
+        int start = offset;
+
+        for(auto f : fields) {
+            QJsonObject field = f.toObject();
+
+            Channel c;
+            c.name = field["name"].toString();
+            c.datatype = field["datatype"].toString();
+            c.offset = offset;
+            c.bits = field["bits"].toInt();
+            c.depth = level;
+            c.isFloat = c.datatype == "float";
+
+            if(c.bits <= 0 || c.bits > 32) {
+                error = QString("field %1 has unsupported size of %2 bits").arg(c.name).arg(c.bits);
+                return -1;
+            }
+
+            if(c.isFloat && c.bits != 32) {
+                error = QString("float field %1 must have 32 bits").arg(c.name);
+                return -1;
+            }
+
+            channels.append(c);
+
+            // bit-fields of the complex field, e.g. the header byte
+            if(field.contains("layout")) {
+                int used = parseFields(field["layout"].toArray(), offset, level + 1);
+                if(used < 0) {
+                    return -1;
+                }
+
+                if(used != c.bits) {
+                    error = QString("bit-fields of %1 take %2 bits instead of %3").arg(c.name).arg(used).arg(c.bits);
+                    return -1;
+                }
+            }
+
+            offset += c.bits;
+        }
+
+        return offset - start;
+    }
+};
+
+#endif // LAYOUT_H
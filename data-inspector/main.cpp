@@ -0,0 +1,297 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <cstdio>
+
+#include "Layout.h"
+
+// the file is processed in chunks of whole records, every chunk by a single thread
+const qint64 CHUNK_BYTES = 4 << 20;
+
+struct Chunk {
+    qint64 first;               // first record of the chunk
+    qint64 count;               // amount of records
+    quint64 checksum;
+    QVector<qint64> histograms; // 256 bins per channel
+};
+
+// FNV-1a over 64-bit words (the tail byte by byte), the xor-shift spreads the high bits of the words into the low ones
+quint64 checksum(const uchar* data, qint64 size, quint64 h = 14695981039346656037ULL)
+{
+    const quint64 prime = 1099511628211ULL;
+
+    qint64 i = 0;
+    for(; i + 8 <= size; i += 8) {
+        quint64 w;
+        memcpy(&w, data + i, sizeof(w));
+        h = (h ^ w) * prime;
+        h ^= h >> 32;
+    }
+
+    for(; i < size; i++) {
+        h = (h ^ data[i]) * prime;
+    }
+
+    return h;
+}
+
+void processChunk(Chunk& chunk, const uchar* data, const Layout& layout)
+{
+    int rb = layout.recordBytes();
+    int channels = layout.channels.size();
+
+    const uchar* begin = data + chunk.first * rb;
+    chunk.checksum = checksum(begin, chunk.count * rb);
+
+    chunk.histograms.fill(0, channels * 256);
+    qint64* hist = chunk.histograms.data();
+
+    for(int c = 0; c < channels; c++) {
+        const Channel& channel = layout.channels[c];
+        qint64* h = hist + c * 256;
+
+        const uchar* record = begin;
+        for(qint64 i = 0; i < chunk.count; i++, record += rb) {
+            h[channel.bin(record)]++;
+        }
+    }
+}
+
+// writes the slice z of the channel as a binary PGM, values are stretched to the full range
+bool writePreview(QString fileName, const uchar* data, const Layout& layout, const Channel& channel, int z)
+{
+    int rb = layout.recordBytes();
+    const uchar* slice = data + (qint64)z * layout.width * layout.height * rb;
+
+    // voxels are ordered by z, then x, then y
+    QByteArray pixels(layout.width * layout.height, 0);
+    int maximum = 1;
+    for(int y = 0; y < layout.height; y++) {
+        for(int x = 0; x < layout.width; x++) {
+            int v = channel.bin(slice + ((qint64)x * layout.height + y) * rb);
+            pixels[y * layout.width + x] = (char)v;
+            maximum = qMax(maximum, v);
+        }
+    }
+
+    for(int i = 0; i < pixels.size(); i++) {
+        pixels[i] = (char)((uchar)pixels[i] * 255 / maximum);
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    file.write(QString("P5\n%1 %2\n255\n").arg(layout.width).arg(layout.height).toLatin1());
+    file.write(pixels);
+    file.close();
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("data-inspector");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Validates a raw volume and its meta file written by the data-generator.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("raw", "Raw volume file.");
+
+    QCommandLineOption metaOption("meta", "Meta file (defaults to the raw file with the .json suffix).", "file");
+    QCommandLineOption threadsOption("threads", "Amount of threads (defaults to all cores).", "count");
+    QCommandLineOption channelOption("channel", "Channel of the slice preview.", "name", "Value");
+    QCommandLineOption sliceOption("slice", "Slice (z) of the preview, defaults to the middle one.", "z");
+    QCommandLineOption previewOption("preview", "Writes the slice preview into the PGM file.", "file");
+    parser.addOption(metaOption);
+    parser.addOption(threadsOption);
+    parser.addOption(channelOption);
+    parser.addOption(sliceOption);
+    parser.addOption(previewOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    if(parser.positionalArguments().size() != 1) {
+        parser.showHelp(2);
+    }
+
+    QString rawFile = parser.positionalArguments()[0];
+    QString metaFile = parser.value(metaOption);
+    if(metaFile.isEmpty()) {
+        QFileInfo info(rawFile);
+        metaFile = info.path() + "/" + info.completeBaseName() + ".json";
+    }
+
+    if(parser.isSet(threadsOption)) {
+        QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+    }
+
+    // meta file descriptor
+    QFile meta(metaFile);
+    if(!meta.open(QIODevice::ReadOnly)) {
+        qCritical() << "cannot open the meta file" << metaFile;
+        return 2;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(meta.readAll(), &parseError);
+    meta.close();
+    if(parseError.error != QJsonParseError::NoError) {
+        qCritical() << "invalid meta file:" << parseError.errorString();
+        return 2;
+    }
+
+    // slabs compressed by the pipelined generator have to be unpacked first
+    QJsonObject general = doc.object()["general"].toObject();
+    if(general.contains("compression")) {
+        qCritical() << "compressed volumes are not supported";
+        return 2;
+    }
+
+    // frames of a time-series after the first one hold only the changed voxels
+    if(general["delta"].toBool()) {
+        qCritical() << "delta frames of a time-series are not supported, inspect the first frame instead";
+        return 2;
+    }
+
+    Layout layout;
+    if(!layout.parse(doc.object())) {
+        qCritical() << "invalid layout:" << layout.error;
+        return 1;
+    }
+
+    out << "volume:   " << layout.width << "x" << layout.height << "x" << layout.depth
+        << ", " << layout.bits << " bits per voxel\n";
+    for(auto& c : layout.channels) {
+        out << "channel:  " << QString(c.depth * 2, ' ') << c.name << " (" << c.datatype << ", "
+            << c.bits << " bits at bit " << c.offset << ")\n";
+    }
+
+    // raw data
+    QFile raw(rawFile);
+    if(!raw.open(QIODevice::ReadOnly)) {
+        qCritical() << "cannot open the raw file" << rawFile;
+        return 2;
+    }
+
+    if(raw.size() != layout.expectedSize()) {
+        out << "ERROR:    file has " << raw.size() << " bytes, " << layout.expectedSize() << " expected\n";
+        return 1;
+    }
+
+    const uchar* data = raw.map(0, raw.size());
+    if(data == nullptr) {
+        qCritical() << "cannot map the raw file" << rawFile;
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 chunkRecords = qMax((qint64)1, CHUNK_BYTES / layout.recordBytes());
+    QVector<Chunk> chunks;
+    for(qint64 first = 0; first < layout.voxels(); first += chunkRecords) {
+        Chunk chunk;
+        chunk.first = first;
+        chunk.count = qMin(chunkRecords, layout.voxels() - first);
+        chunks.append(chunk);
+    }
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk& chunk) {
+        processChunk(chunk, data, layout);
+    });
+
+    // reduction, the checksum of the file is the checksum of the chunk checksums
+    int channels = layout.channels.size();
+    QVector<qint64> histograms(channels * 256, 0);
+    QVector<quint64> checksums;
+    for(auto& chunk : chunks) {
+        for(int i = 0; i < histograms.size(); i++) {
+            histograms[i] += chunk.histograms[i];
+        }
+        checksums.append(chunk.checksum);
+    }
+    quint64 sum = checksum((const uchar*)checksums.constData(), checksums.size() * sizeof(quint64));
+
+    qint64 elapsed = qMax((qint64)1, timer.elapsed());
+    out << "checksum: " << QString::number(sum, 16).rightJustified(16, '0') << "\n";
+    out << "time:     " << elapsed << " ms (" << (raw.size() / 1048576.0) / (elapsed / 1000.0) << " MB/s)\n";
+
+    // histograms of all channels (non-empty bins only)
+    for(int c = 0; c < channels; c++) {
+        out << "histogram " << layout.channels[c].name << ":";
+        for(int b = 0; b < 256; b++) {
+            if(histograms[c * 256 + b] > 0) {
+                out << " " << b << "=" << histograms[c * 256 + b];
+            }
+        }
+        out << "\n";
+    }
+
+    bool valid = true;
+
+    // padding has to be zero
+    int padding = layout.indexOf("Padding");
+    if(padding >= 0 && histograms[padding * 256] != layout.voxels()) {
+        out << "ERROR:    padding contains non-zero values\n";
+        valid = false;
+    }
+
+    // voxels per ID, compared with the statistics gathered by the generator if present
+    int id = layout.indexOf("ID");
+    if(id >= 0) {
+        const qint64* ids = histograms.constData() + id * 256;
+
+        QJsonObject voxels = doc.object()["stats"].toObject()["voxels"].toObject();
+        for(auto e : voxels["elements"].toArray()) {
+            QJsonObject element = e.toObject();
+            int elementId = element["id"].toInt();
+            qint64 expected = (qint64)element["voxels"].toDouble();
+
+            if(elementId >= 0 && elementId < 256 && ids[elementId] != expected) {
+                out << "ERROR:    ID " << elementId << " has " << ids[elementId] << " voxels, meta file says " << expected << "\n";
+                valid = false;
+            }
+        }
+
+        if(voxels.contains("occupied") && layout.voxels() - ids[0] != (qint64)voxels["occupied"].toDouble()) {
+            out << "ERROR:    " << layout.voxels() - ids[0] << " occupied voxels, meta file says "
+                << (qint64)voxels["occupied"].toDouble() << "\n";
+            valid = false;
+        }
+    }
+
+    // slice preview
+    if(parser.isSet(previewOption)) {
+        int channel = layout.indexOf(parser.value(channelOption));
+        int z = parser.isSet(sliceOption) ? parser.value(sliceOption).toInt() : layout.depth / 2;
+
+        if(channel < 0 || z < 0 || z >= layout.depth) {
+            qCritical() << "invalid channel or slice of the preview";
+            return 2;
+        }
+
+        if(!writePreview(parser.value(previewOption), data, layout, layout.channels[channel], z)) {
+            qCritical() << "cannot write the preview" << parser.value(previewOption);
+            return 2;
+        }
+    }
+
+    out << (valid ? "OK\n" : "INVALID\n");
+
+    raw.unmap((uchar*)data);
+    raw.close();
+
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+#ifndef BVPWRITER_H
+#define BVPWRITER_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtEndian>
+
+// CRC-32 (IEEE) required by the ZIP entries
+class CRC32 {
+public:
+    static quint32 compute(const uchar* data, qint64 size) {
+        static const Table table;
+
+        quint32 crc = 0xffffffff;
+        for(qint64 i = 0; i < size; i++) {
+            crc = table.values[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+
+        return crc ^ 0xffffffff;
+    }
+
+private:
+    struct Table {
+        quint32 values[256];
+
+        Table() {
+            for(quint32 i = 0; i < 256; i++) {
+                quint32 c = i;
+                for(int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+                }
+                values[i] = c;
+            }
+        }
+    };
+};
+
+// writes a BVP archive: a ZIP with the manifest.json and one entry per block
+// entries are stored without compression since ZIPReader reads them as they are,
+// the ZIP is limited to 4 GB and 65535 entries (no ZIP64)
+class BVPWriter {
+private:
+    struct Entry {
+        QByteArray name;
+        quint32 crc;
+        quint32 size;
+        quint32 offset;
+    };
+
+    QFile _file;
+    QVector<Entry> _entries;
+    QJsonArray _blocks;
+    QJsonArray _placements;
+
+public:
+    QString error;
+
+    bool open(QString fileName) {
+        _file.setFileName(fileName);
+        if(!_file.open(QIODevice::WriteOnly)) {
+            error = "cannot open " + fileName;
+            return false;
+        }
+
+        return true;
+    }
+
+    // appends a block of the default modality placed at the given position
+    bool addBlock(const QByteArray& data, quint32 crc, int x, int y, int z, int width, int height, int depth) {
+        int index = _blocks.size();
+        QString url = QString("blocks/default/%1.raw").arg(index);
+
+        if(!addEntry(url.toLatin1(), data, crc)) {
+            return false;
+        }
+
+        QJsonObject dimensions;
+        dimensions["width"] = width;
+        dimensions["height"] = height;
+        dimensions["depth"] = depth;
+
+        QJsonObject block;
+        block["url"] = url;
+        block["format"] = "raw";
+        block["dimensions"] = dimensions;
+        _blocks.append(block);
+
+        QJsonObject position;
+        position["x"] = x;
+        position["y"] = y;
+        position["z"] = z;
+
+        QJsonObject placement;
+        placement["index"] = index;
+        placement["position"] = position;
+        _placements.append(placement);
+
+        return true;
+    }
+
+    // writes the manifest, the central directory and closes the archive
+    bool finish(QString name, int width, int height, int depth, int components, const float* scale) {
+        QJsonObject meta;
+        meta["version"] = 1;
+        meta["name"] = name;
+
+        QJsonObject dimensions;
+        dimensions["width"] = width;
+        dimensions["height"] = height;
+        dimensions["depth"] = depth;
+
+        QJsonArray matrix = {
+            scale[0], 0, 0, 0,
+            0, scale[1], 0, 0,
+            0, 0, scale[2], 0,
+            0, 0, 0, 1
+        };
+        QJsonObject transform;
+        transform["matrix"] = matrix;
+
+        QJsonObject modality;
+        modality["name"] = "default";
+        modality["dimensions"] = dimensions;
+        modality["transform"] = transform;
+        modality["components"] = components;
+        modality["bits"] = 8;
+        modality["placements"] = _placements;
+
+        QJsonArray modalities;
+        modalities.append(modality);
+
+        QJsonObject manifest;
+        manifest["meta"] = meta;
+        manifest["modalities"] = modalities;
+        manifest["blocks"] = _blocks;
+
+        QByteArray json = QJsonDocument(manifest).toJson();
+        if(!addEntry("manifest.json", json, CRC32::compute((const uchar*)json.constData(), json.size()))) {
+            return false;
+        }
+
+        // central directory
+        qint64 start = _file.pos();
+        for(auto& e : _entries) {
+            uchar header[46];
+            qToLittleEndian<quint32>(0x02014b50, header);   // signature
+            qToLittleEndian<quint16>(20, header + 4);       // version made by
+            qToLittleEndian<quint16>(10, header + 6);       // version needed
+            qToLittleEndian<quint16>(0, header + 8);        // flags
+            qToLittleEndian<quint16>(0, header + 10);       // method (stored)
+            qToLittleEndian<quint16>(0, header + 12);       // time
+            qToLittleEndian<quint16>(0x21, header + 14);    // date (1980-01-01)
+            qToLittleEndian<quint32>(e.crc, header + 16);
+            qToLittleEndian<quint32>(e.size, header + 20);  // compressed size
+            qToLittleEndian<quint32>(e.size, header + 24);  // uncompressed size
+            qToLittleEndian<quint16>(e.name.size(), header + 28);
+            qToLittleEndian<quint16>(0, header + 30);       // extra field length
+            qToLittleEndian<quint16>(0, header + 32);       // comment length
+            qToLittleEndian<quint16>(0, header + 34);       // disk
+            qToLittleEndian<quint16>(0, header + 36);       // internal attributes
+            qToLittleEndian<quint32>(0, header + 38);       // external attributes
+            qToLittleEndian<quint32>(e.offset, header + 42);
+
+            _file.write((const char*)header, sizeof(header));
+            _file.write(e.name);
+        }
+        qint64 size = _file.pos() - start;
+
+        if(_entries.size() > 0xffff || _file.pos() > 0xffffffffLL) {
+            error = "archive exceeds the ZIP limits (4 GB, 65535 entries), use larger blocks";
+            return false;
+        }
+
+        // end of central directory
+        uchar eocd[22];
+        qToLittleEndian<quint32>(0x06054b50, eocd);
+        qToLittleEndian<quint16>(0, eocd + 4);
+        qToLittleEndian<quint16>(0, eocd + 6);
+        qToLittleEndian<quint16>(_entries.size(), eocd + 8);
+        qToLittleEndian<quint16>(_entries.size(), eocd + 10);
+        qToLittleEndian<quint32>(size, eocd + 12);
+        qToLittleEndian<quint32>(start, eocd + 16);
+        qToLittleEndian<quint16>(0, eocd + 20);
+        _file.write((const char*)eocd, sizeof(eocd));
+
+        _file.close();
+
+        return true;
+    }
+
+private:
+    bool addEntry(const QByteArray& name, const QByteArray& data, quint32 crc) {
+        qint64 offset = _file.pos();
+        if(offset + 30 + name.size() + data.size() > 0xffffffffLL) {
+            error = "archive exceeds the ZIP limits (4 GB, 65535 entries), use larger blocks";
+            return false;
+        }
+
+        uchar header[30];
+        qToLittleEndian<quint32>(0x04034b50, header);   // signature
+        qToLittleEndian<quint16>(10, header + 4);       // version needed
+        qToLittleEndian<quint16>(0, header + 6);        // flags
+        qToLittleEndian<quint16>(0, header + 8);        // method (stored)
+        qToLittleEndian<quint16>(0, header + 10);       // time
+        qToLittleEndian<quint16>(0x21, header + 12);    // date (1980-01-01)
+        qToLittleEndian<quint32>(crc, header + 14);
+        qToLittleEndian<quint32>(data.size(), header + 18);
+        qToLittleEndian<quint32>(data.size(), header + 22);
+        qToLittleEndian<quint16>(name.size(), header + 26);
+        qToLittleEndian<quint16>(0, header + 28);       // extra field length
+
+        _file.write((const char*)header, sizeof(header));
+        _file.write(name);
+        if(_file.write(data) != data.size()) {
+            error = "cannot write the archive";
+            return false;
+        }
+
+        Entry e;
+        e.name = name;
+        e.crc = crc;
+        e.size = data.size();
+        e.offset = offset;
+        _entries.append(e);
+
+        return true;
+    }
+};
+
+#endif // BVPWRITER_H
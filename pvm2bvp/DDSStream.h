@@ -0,0 +1,329 @@
+#ifndef DDSSTREAM_H
+#define DDSSTREAM_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QtGlobal>
+
+// sequential decoder of the DDS packed files (DDS v3d, DDS v3e) of the V^3 library, most PVM scans are stored
+// this way, the file is unpacked on the fly while it is read, so no unpacked copy is ever held or written
+//
+// the packed file is a bit stream (most significant bit first):
+// - skip - 1 (2 bits) and strip - 1 (16 bits)
+// - runs of values: length (7 bits, 0=end of the stream), bits per value (3 bits: 0, or 2 to 8 bits), values
+// - a value is the difference to the prediction (the previous byte, plus the difference of the bytes strip
+//   and strip + 1 back once there are enough of them) biased by a half of its range, all modulo 256
+// - the bytes of the skip components are stored one component after another, v3d interleaves the whole
+//   stream at once and v3e in blocks of skip * 2^24 bytes
+class DDSStream {
+private:
+    static const int INTERLEAVE = 1 << 24;      // values per component of a v3e block
+    static const int CHECKPOINT = 1 << 24;      // unpacked bytes between two saved decoder states
+    static const int CHUNK = 1 << 16;           // bytes read from the file at once
+
+    // state of the decoder at some point of the packed stream
+    struct State {
+        qint64 offset = 0;          // offset of the next byte of the file
+        quint64 buffer = 0;         // bits read from the file but not used yet
+        int bufferBits = 0;
+        int run = 0;                // values left in the current run
+        int bits = 0;               // bits per value of the current run
+        int act = 0;                // last decoded byte
+        qint64 count = 0;           // bytes decoded so far
+        bool end = false;
+        bool truncated = false;     // the stream went past the end of the file
+        QByteArray history;         // last decoded bytes (ring) for the strip prediction
+    };
+
+    // decoder walking through the stream, every component of an interleaved stream has its own
+    class Cursor {
+    private:
+        QFile _file;
+        QByteArray _chunk;
+        int _chunkPos = 0;
+        int _strip = 1;
+        int _mask = 0;
+
+        inline uint nextByte() {
+            if(_chunkPos == _chunk.size()) {
+                _chunk = _file.read(CHUNK);
+                _chunkPos = 0;
+                if(_chunk.isEmpty()) {
+                    state.truncated = true;
+                    return 0;
+                }
+            }
+
+            state.offset++;
+            return (uchar)_chunk[_chunkPos++];
+        }
+
+        inline uint readBits(int bits) {
+            if(bits == 0) {
+                return 0;
+            }
+
+            while(state.bufferBits < bits) {
+                state.buffer = (state.buffer << 8) | nextByte();
+                state.bufferBits += 8;
+            }
+
+            state.bufferBits -= bits;
+            return (state.buffer >> state.bufferBits) & ((1u << bits) - 1);
+        }
+
+    public:
+        State state;
+
+        bool open(QString fileName, qint64 offset) {
+            _file.setFileName(fileName);
+            state.offset = offset;
+
+            return _file.open(QIODevice::ReadOnly) && _file.seek(offset);
+        }
+
+        void setStrip(int strip) {
+            // the ring holds at least strip + 2 bytes
+            int ring = 1;
+            while(ring < strip + 2) {
+                ring <<= 1;
+            }
+
+            _strip = strip;
+            _mask = ring - 1;
+            state.history = QByteArray(ring, 0);
+        }
+
+        // continues from the given state
+        bool restore(const State& s) {
+            state = s;
+            _chunk.clear();
+            _chunkPos = 0;
+
+            return _file.seek(s.offset);
+        }
+
+        // header bits of the stream following the magic
+        void readHeader(int& skip, int& strip) {
+            skip = readBits(2) + 1;
+            strip = readBits(16) + 1;
+        }
+
+        // decodes up to n bytes, less only at the end of the stream
+        qint64 decode(uchar* dst, qint64 n) {
+            uchar* history = (uchar*)state.history.data();
+            qint64 done = 0;
+
+            while(done < n) {
+                if(state.run == 0) {
+                    state.run = readBits(7);
+                    if(state.run == 0) {
+                        state.end = true;
+                        break;
+                    }
+
+                    int code = readBits(3);
+                    state.bits = code >= 1 ? code + 1 : 0;
+                }
+
+                int value = (int)readBits(state.bits) - ((1 << state.bits) >> 1);
+                if(_strip == 1 || state.count <= _strip) {
+                    state.act += value;
+                } else {
+                    state.act += history[(state.count - _strip) & _mask] - history[(state.count - _strip - 1) & _mask] + value;
+                }
+                state.act &= 0xff;
+
+                history[state.count & _mask] = state.act;
+                dst[done++] = state.act;
+                state.count++;
+                state.run--;
+            }
+
+            return done;
+        }
+    };
+
+    int _version = 0;
+    int _skip = 1;
+    int _strip = 1;
+    qint64 _size = -1;          // unpacked bytes (-1=unknown, only interleaved streams are scanned for it)
+    qint64 _pos = 0;            // unpacked bytes handed out so far
+
+    QList<Cursor*> _cursors;    // one per component
+    QList<State> _checkpoints;  // every CHECKPOINT unpacked bytes
+
+    // the current interleaved block: start, length and the bytes of the components waiting to be handed out
+    qint64 _blockStart = 0;
+    qint64 _blockLength = 0;
+    int _component = 0;
+    QVector<QByteArray> _planes;
+    QVector<int> _planePos;
+
+    // moves the cursor to the given position of the packed stream
+    bool seek(Cursor* cursor, qint64 position) {
+        int i = qMin((int)(position / CHECKPOINT), _checkpoints.size() - 1);
+        if(!cursor->restore(_checkpoints[i])) {
+            return false;
+        }
+
+        QByteArray scratch(CHUNK, 0);
+        while(cursor->state.count < position) {
+            qint64 n = qMin((qint64)CHUNK, position - cursor->state.count);
+            if(cursor->decode((uchar*)scratch.data(), n) != n) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // positions the cursors at the components of the block starting at the given position
+    bool enterBlock(qint64 start) {
+        _blockStart = start;
+        _blockLength = qMin(_version == 1 ? _size : (qint64)_skip * INTERLEAVE, _size - start);
+
+        _component = 0;
+
+        qint64 position = start;
+        for(int i = 0; i < _skip; i++) {
+            if(!seek(_cursors[i], position)) {
+                error = "corrupted DDS stream";
+                return false;
+            }
+
+            _planes[i].clear();
+            _planePos[i] = 0;
+
+            // component i holds the bytes i, i + skip, ... of the block
+            position += (_blockLength - i + _skip - 1) / _skip;
+        }
+
+        return true;
+    }
+
+public:
+    QString error;
+
+    ~DDSStream() {
+        qDeleteAll(_cursors);
+    }
+
+    bool isOpen() const { return !_cursors.isEmpty(); }
+
+    // unpacked size, -1 if it is not known before the whole stream is read
+    qint64 size() const { return _size; }
+
+    qint64 pos() const { return _pos; }
+
+    bool atEnd() const {
+        return _skip == 1 ? _cursors[0]->state.end : _pos == _size;
+    }
+
+    // tests the magic of the file
+    static bool isDDS(QByteArray magic) {
+        return magic.startsWith("DDS v3d\n") || magic.startsWith("DDS v3e\n");
+    }
+
+    bool open(QString fileName) {
+        QFile file(fileName);
+        if(!file.open(QIODevice::ReadOnly)) {
+            error = "cannot open " + fileName;
+            return false;
+        }
+
+        QByteArray magic = file.read(8);
+        if(magic == "DDS v3d\n") {
+            _version = 1;
+        } else if(magic == "DDS v3e\n") {
+            _version = 2;
+        } else {
+            error = "not a DDS file";
+            return false;
+        }
+        file.close();
+
+        for(int i = 0; i < _skip; i++) {
+            Cursor* cursor = new Cursor;
+            _cursors.append(cursor);
+            if(!cursor->open(fileName, magic.size())) {
+                error = "cannot open " + fileName;
+                return false;
+            }
+
+            // the amount of the components is known once the first cursor has read the header
+            if(i == 0) {
+                cursor->readHeader(_skip, _strip);
+            }
+            cursor->setStrip(_strip);
+        }
+        _checkpoints.append(_cursors[0]->state);
+
+        _planes.resize(_skip);
+        _planePos.resize(_skip);
+
+        if(_skip == 1) {
+            return true;
+        }
+
+        // the components of interleaved streams are spread over the whole block, so the stream is scanned
+        // once for its size and the states of the decoder are saved on the way to jump to the components later
+        QByteArray scratch(CHUNK, 0);
+        Cursor* scan = _cursors[0];
+        while(!scan->state.end) {
+            scan->decode((uchar*)scratch.data(), CHUNK);
+            if(scan->state.count % CHECKPOINT == 0 && !scan->state.end) {
+                _checkpoints.append(scan->state);
+            }
+        }
+        _size = scan->state.count;
+
+        if(scan->state.truncated) {
+            error = "truncated DDS stream";
+            return false;
+        }
+
+        return enterBlock(0);
+    }
+
+    // hands out the next n unpacked bytes, returns the amount of them (less only at the end of the stream)
+    qint64 read(uchar* dst, qint64 n) {
+        if(_skip == 1) {
+            qint64 done = _cursors[0]->decode(dst, n);
+            _pos += done;
+            return done;
+        }
+
+        qint64 done = 0;
+        while(done < n && _pos < _size) {
+            if(_pos == _blockStart + _blockLength && !enterBlock(_pos)) {
+                break;
+            }
+
+            // byte p of the block is the byte p / skip of the component p % skip
+            int i = _component;
+            if(_planePos[i] == _planes[i].size()) {
+                qint64 index = (_pos - _blockStart) / _skip;
+                qint64 left = (_blockLength - i + _skip - 1) / _skip - index;
+
+                _planes[i].resize((int)qMin((qint64)CHUNK, left));
+                _planePos[i] = 0;
+                if(_cursors[i]->decode((uchar*)_planes[i].data(), _planes[i].size()) != _planes[i].size()) {
+                    error = "truncated DDS stream";
+                    break;
+                }
+            }
+
+            dst[done++] = _planes[i].constData()[_planePos[i]++];
+            _component = i + 1 < _skip ? i + 1 : 0;
+            _pos++;
+        }
+
+        return done;
+    }
+};
+
+#endif // DDSSTREAM_H
@@ -0,0 +1,256 @@
+#ifndef VOLUMEREADER_H
+#define VOLUMEREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QtGlobal>
+#include <cstring>
+
+#include "DDSStream.h"
+
+// reads the voxels of a PVM or RAW volume in parts, the whole volume is never loaded
+// voxels are ordered by x, then y, then z (the same order as texSubImage3D expects)
+// DDS packed PVM files are unpacked on the fly, they can only be read front to back (by increasing z)
+class VolumeReader {
+private:
+    QFile _file;
+    qint64 _dataOffset = 0;
+
+    // DDS packed volume: the stream and the slices [_windowZ0, _windowZ1) unpacked from it
+    DDSStream _dds;
+    QByteArray _window;
+    int _windowZ0 = 0;
+    int _windowZ1 = 0;
+
+public:
+    int width = 0;
+    int height = 0;
+    int depth = 0;
+    int components = 1;     // bytes per voxel
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+
+    QString error;
+
+    // opens a PVM (PVM, PVM2, PVM3), plain or DDS packed, the dimensions are read from the header
+    bool openPVM(QString fileName) {
+        _file.setFileName(fileName);
+        if(!_file.open(QIODevice::ReadOnly)) {
+            error = "cannot open " + fileName;
+            return false;
+        }
+
+        if(DDSStream::isDDS(_file.peek(8))) {
+            _file.close();
+            if(!_dds.open(fileName)) {
+                error = _dds.error;
+                return false;
+            }
+        }
+
+        QByteArray magic = readLine(16);
+        int version = 0;
+        if(magic == "PVM\n") {
+            version = 1;
+        } else if(magic == "PVM2\n") {
+            version = 2;
+        } else if(magic == "PVM3\n") {
+            version = 3;
+        } else {
+            error = "not a PVM file";
+            return false;
+        }
+
+        // header lines: dimensions, scale (since PVM2) and bytes per voxel, comments start with #
+        QList<QByteArray> lines;
+        int needed = version == 1 ? 2 : 3;
+        while(lines.size() < needed && !atEnd()) {
+            QByteArray line = readLine(256).trimmed();
+            if(!line.isEmpty() && !line.startsWith("#")) {
+                lines.append(line);
+            }
+        }
+
+        if(lines.size() != needed) {
+            error = "truncated PVM header";
+            return false;
+        }
+
+        QList<QByteArray> dims = lines[0].simplified().split(' ');
+        if(dims.size() != 3) {
+            error = "invalid PVM dimensions";
+            return false;
+        }
+        width = dims[0].toInt();
+        height = dims[1].toInt();
+        depth = dims[2].toInt();
+
+        if(version > 1) {
+            QList<QByteArray> s = lines[1].simplified().split(' ');
+            for(int i = 0; i < 3 && i < s.size(); i++) {
+                scale[i] = (float)s[i].toDouble();
+            }
+        }
+
+        components = lines[needed - 1].toInt();
+        _dataOffset = _dds.isOpen() ? _dds.pos() : _file.pos();
+
+        return validate();
+    }
+
+    // opens a headerless RAW volume of the given dimensions
+    bool openRAW(QString fileName, int w, int h, int d, int c) {
+        _file.setFileName(fileName);
+        if(!_file.open(QIODevice::ReadOnly)) {
+            error = "cannot open " + fileName;
+            return false;
+        }
+
+        width = w;
+        height = h;
+        depth = d;
+        components = c;
+        _dataOffset = 0;
+
+        return validate();
+    }
+
+    inline qint64 rowBytes() const { return (qint64)width * components; }
+    inline qint64 sliceBytes() const { return rowBytes() * height; }
+
+    // memory held by the reader while reading the given amount of slices at once
+    qint64 bufferBytes(int slices) const {
+        return _dds.isOpen() ? slices * sliceBytes() : 0;
+    }
+
+    // reads the box [x0, x1) x [y0, y1) x [z0, z1) into data, one row (along x) at a time
+    bool read(int x0, int y0, int z0, int x1, int y1, int z1, uchar* data) {
+        if(_dds.isOpen()) {
+            return readPacked(x0, y0, z0, x1, y1, z1, data);
+        }
+
+        qint64 length = (qint64)(x1 - x0) * components;
+        bool whole = x0 == 0 && x1 == width;
+
+        for(int z = z0; z < z1; z++) {
+            qint64 slice = _dataOffset + (qint64)z * height * rowBytes();
+
+            // full rows are contiguous in the file, one read per slice is enough
+            if(whole) {
+                qint64 size = (qint64)(y1 - y0) * length;
+                if(!_file.seek(slice + y0 * rowBytes()) || _file.read((char*)data, size) != size) {
+                    error = "unexpected end of the volume data";
+                    return false;
+                }
+                data += size;
+                continue;
+            }
+
+            for(int y = y0; y < y1; y++) {
+                if(!_file.seek(slice + y * rowBytes() + x0 * components) || _file.read((char*)data, length) != length) {
+                    error = "unexpected end of the volume data";
+                    return false;
+                }
+                data += length;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    QByteArray readLine(qint64 maxSize) {
+        if(!_dds.isOpen()) {
+            return _file.readLine(maxSize);
+        }
+
+        QByteArray line;
+        uchar c;
+        while(line.size() < maxSize - 1 && _dds.read(&c, 1) == 1) {
+            line.append(c);
+            if(c == '\n') {
+                break;
+            }
+        }
+
+        return line;
+    }
+
+    bool atEnd() const {
+        return _dds.isOpen() ? _dds.atEnd() : _file.atEnd();
+    }
+
+    // slices are unpacked into the window as the reading moves on, the slices still needed are kept
+    bool readPacked(int x0, int y0, int z0, int x1, int y1, int z1, uchar* data) {
+        if(z0 < _windowZ0) {
+            error = "DDS packed volumes can only be read front to back";
+            return false;
+        }
+
+        if(z1 > _windowZ1) {
+            // slices before z0 are not needed anymore, the ones already unpacked after it are kept
+            // the buffer is reused, so at most one window is held (the memory budget counts one)
+            int keep = qMax(0, _windowZ1 - z0);
+            if(keep > 0) {
+                memmove(_window.data(), _window.constData() + (qint64)(z0 - _windowZ0) * sliceBytes(), keep * sliceBytes());
+            } else {
+                // the old slices are released before the new ones are allocated
+                _window.clear();
+            }
+            _window.resize((qint64)(z1 - z0) * sliceBytes());
+            char* window = _window.data();
+
+            // slices skipped by the reading are unpacked and dropped
+            for(int z = _windowZ1; z < z0; z++) {
+                if(_dds.read((uchar*)window, sliceBytes()) != sliceBytes()) {
+                    error = "unexpected end of the volume data";
+                    return false;
+                }
+            }
+
+            qint64 size = (qint64)(z1 - z0 - keep) * sliceBytes();
+            if(_dds.read((uchar*)window + keep * sliceBytes(), size) != size) {
+                error = "unexpected end of the volume data";
+                return false;
+            }
+
+            _windowZ0 = z0;
+            _windowZ1 = z1;
+        }
+
+        qint64 length = (qint64)(x1 - x0) * components;
+        for(int z = z0; z < z1; z++) {
+            const char* slice = _window.constData() + (qint64)(z - _windowZ0) * sliceBytes();
+            for(int y = y0; y < y1; y++) {
+                memcpy(data, slice + y * rowBytes() + x0 * components, length);
+                data += length;
+            }
+        }
+
+        return true;
+    }
+
+    bool validate() {
+        if(width <= 0 || height <= 0 || depth <= 0) {
+            error = "invalid dimensions";
+            return false;
+        }
+
+        if(components < 1 || components > 2) {
+            error = QString("%1 bytes per voxel are not supported (1 or 2 expected)").arg(components);
+            return false;
+        }
+
+        // the size of a DDS packed stream is known only if it had to be scanned, it is checked while reading otherwise
+        qint64 size = _dds.isOpen() ? _dds.size() : _file.size();
+        if(size >= 0 && size < _dataOffset + (qint64)width * height * depth * components) {
+            error = "volume data is shorter than its dimensions";
+            return false;
+        }
+
+        return true;
+    }
+};
+
+#endif // VOLUMEREADER_H
@@ -0,0 +1,169 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QDebug>
+
+#include "VolumeReader.h"
+#include "BVPWriter.h"
+
+// block of the output, cut out of the strip read from the input
+struct Block {
+    int x0, y0, z0;
+    int x1, y1, z1;
+    QByteArray data;
+    quint32 crc;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("pvm2bvp");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts a PVM (or RAW) volume into a bricked BVP archive.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "PVM volume, plain or DDS packed (or RAW with --raw).");
+    parser.addPositionalArgument("output", "BVP archive.");
+
+    QCommandLineOption rawOption("raw", "Input is a headerless RAW volume of the given dimensions.", "WxHxD");
+    QCommandLineOption componentsOption("components", "Bytes per voxel of the RAW volume.", "count", "1");
+    QCommandLineOption brickOption("brick", "Size of the blocks.", "size", "128");
+    QCommandLineOption memoryOption("memory", "Memory budget in MB.", "MB", "512");
+    QCommandLineOption threadsOption("threads", "Amount of threads (defaults to all cores).", "count");
+    parser.addOption(rawOption);
+    parser.addOption(componentsOption);
+    parser.addOption(brickOption);
+    parser.addOption(memoryOption);
+    parser.addOption(threadsOption);
+    parser.process(app);
+
+    if(parser.positionalArguments().size() != 2) {
+        parser.showHelp(2);
+    }
+
+    QString input = parser.positionalArguments()[0];
+    QString output = parser.positionalArguments()[1];
+
+    if(parser.isSet(threadsOption)) {
+        QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+    }
+
+    VolumeReader reader;
+    bool opened;
+    if(parser.isSet(rawOption)) {
+        QList<QByteArray> dims = parser.value(rawOption).toLatin1().split('x');
+        if(dims.size() != 3) {
+            qCritical() << "invalid dimensions" << parser.value(rawOption);
+            return 2;
+        }
+        opened = reader.openRAW(input, dims[0].toInt(), dims[1].toInt(), dims[2].toInt(), parser.value(componentsOption).toInt());
+    } else {
+        opened = reader.openPVM(input);
+    }
+
+    if(!opened) {
+        qCritical() << input << ":" << reader.error;
+        return 1;
+    }
+
+    int brick = parser.value(brickOption).toInt();
+    qint64 budget = parser.value(memoryOption).toLongLong() << 20;
+    qint64 brickBytes = (qint64)brick * brick * brick * reader.components;
+
+    if(brick <= 0) {
+        qCritical() << "invalid brick size";
+        return 2;
+    }
+
+    // slices unpacked from a DDS packed input are held by the reader
+    budget -= reader.bufferBytes(brick);
+
+    // the strip read from the input and the blocks cut out of it take at most a half of the budget each
+    int bricksX = (reader.width + brick - 1) / brick;
+    int groupBricks = (int)qMin((qint64)bricksX, budget / (2 * brickBytes));
+    if(groupBricks < 1) {
+        qCritical() << "brick of" << brickBytes << "bytes does not fit into the memory budget";
+        return 2;
+    }
+
+    BVPWriter writer;
+    if(!writer.open(output)) {
+        qCritical() << writer.error;
+        return 2;
+    }
+
+    qDebug() << reader.width << "x" << reader.height << "x" << reader.depth << "," << reader.components << "bytes per voxel";
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray strip;
+    int c = reader.components;
+
+    for(int z0 = 0; z0 < reader.depth; z0 += brick) {
+        for(int y0 = 0; y0 < reader.height; y0 += brick) {
+            for(int bx = 0; bx < bricksX; bx += groupBricks) {
+                int z1 = qMin(z0 + brick, reader.depth);
+                int y1 = qMin(y0 + brick, reader.height);
+                int sx0 = bx * brick;
+                int sx1 = qMin((bx + groupBricks) * brick, reader.width);
+
+                // one run of bricks along x is read at once
+                qint64 sw = sx1 - sx0;
+                strip.resize(sw * (y1 - y0) * (z1 - z0) * c);
+                if(!reader.read(sx0, y0, z0, sx1, y1, z1, (uchar*)strip.data())) {
+                    qCritical() << input << ":" << reader.error;
+                    return 1;
+                }
+
+                QVector<Block> blocks;
+                for(int x0 = sx0; x0 < sx1; x0 += brick) {
+                    Block b;
+                    b.x0 = x0;
+                    b.y0 = y0;
+                    b.z0 = z0;
+                    b.x1 = qMin(x0 + brick, sx1);
+                    b.y1 = y1;
+                    b.z1 = z1;
+                    blocks.append(b);
+                }
+
+                // blocks are cut out and checksummed in parallel
+                QtConcurrent::blockingMap(blocks, [&](Block& b) {
+                    qint64 row = (qint64)(b.x1 - b.x0) * c;
+                    b.data.resize(row * (b.y1 - b.y0) * (b.z1 - b.z0));
+
+                    char* dst = b.data.data();
+                    for(int z = b.z0; z < b.z1; z++) {
+                        for(int y = b.y0; y < b.y1; y++) {
+                            const char* src = strip.constData() + (((qint64)(z - z0) * (y1 - y0) + (y - y0)) * sw + (b.x0 - sx0)) * c;
+                            memcpy(dst, src, row);
+                            dst += row;
+                        }
+                    }
+
+                    b.crc = CRC32::compute((const uchar*)b.data.constData(), b.data.size());
+                });
+
+                for(auto& b : blocks) {
+                    if(!writer.addBlock(b.data, b.crc, b.x0, b.y0, b.z0, b.x1 - b.x0, b.y1 - b.y0, b.z1 - b.z0)) {
+                        qCritical() << output << ":" << writer.error;
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    if(!writer.finish(QFileInfo(input).completeBaseName(), reader.width, reader.height, reader.depth, c, reader.scale)) {
+        qCritical() << output << ":" << writer.error;
+        return 1;
+    }
+
+    qDebug() << "written to:" << QFileInfo(output).absoluteFilePath() << "in" << timer.elapsed() << "ms";
+
+    return 0;
+}
@@ -69,10 +69,11 @@ _readShort(data, index) {
 }
 
 _readInt(data, index) {
-    return data[index]
+    // unsigned, offsets and sizes of archives above 2 GB would turn negative
+    return (data[index]
         | (data[index + 1] << 8)
         | (data[index + 2] << 16)
-        | (data[index + 3] << 24);
+        | (data[index + 3] << 24)) >>> 0;
 }
 
 _readString(data, index, length) {